@@ -1,6 +1,11 @@
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 /*
 The Builder design pattern is a creational pattern used to construct a complex object step by step. 
@@ -83,8 +88,179 @@ public:
         car.gps = "Built-in";
     }
 
+    // Moves the finished car out and leaves the builder ready for the next
     Car getCar() override {
-        return car;
+        Car built = std::move(car);
+        car = Car();
+        return built;
+    }
+};
+
+// Interned attribute values; each distinct string is stored once and cars
+// refer to it by a small code. Code 0 is always the empty string, the
+// value of a part no build step has set.
+class AttributePool {
+public:
+    using Code = std::uint16_t;
+
+    static constexpr Code unset = 0;
+
+private:
+    std::vector<std::string> values;
+    std::unordered_map<std::string, Code> codes;
+
+public:
+    AttributePool() {
+        intern("");
+    }
+
+    Code intern(const std::string& value) {
+        auto it = codes.find(value);
+        if (it != codes.end()) {
+            return it->second;
+        }
+        if (values.size() > UINT16_MAX) {
+            throw std::length_error("too many distinct attribute values");
+        }
+        Code code = static_cast<Code>(values.size());
+        values.push_back(value);
+        codes.emplace(value, code);
+        return code;
+    }
+
+    bool find(const std::string& value, Code& code) const {
+        auto it = codes.find(value);
+        if (it == codes.end()) {
+            return false;
+        }
+        code = it->second;
+        return true;
+    }
+
+    const std::string& value(Code code) const {
+        return values[code];
+    }
+};
+
+// The 'Product' for batches: one column of attribute codes per part
+class CarBatch {
+public:
+    using Code = AttributePool::Code;
+
+    struct Row {
+        Code seats = AttributePool::unset;
+        Code engine = AttributePool::unset;
+        Code tripComputer = AttributePool::unset;
+        Code gps = AttributePool::unset;
+    };
+
+private:
+    std::shared_ptr<const AttributePool> attributes;
+    std::vector<Code> seats;
+    std::vector<Code> engine;
+    std::vector<Code> tripComputer;
+    std::vector<Code> gps;
+
+public:
+    explicit CarBatch(std::shared_ptr<const AttributePool> attributes) : attributes(std::move(attributes)) {}
+
+    void reserve(std::size_t count) {
+        seats.reserve(count);
+        engine.reserve(count);
+        tripComputer.reserve(count);
+        gps.reserve(count);
+    }
+
+    void append(const Row& row) {
+        seats.push_back(row.seats);
+        engine.push_back(row.engine);
+        tripComputer.push_back(row.tripComputer);
+        gps.push_back(row.gps);
+    }
+
+    std::size_t size() const { return seats.size(); }
+
+    static constexpr std::size_t bytesPerCar() { return sizeof(Row); }
+
+    // Materialises a single car when an object is really needed
+    Car car(std::size_t index) const {
+        Car result;
+        result.seats = attributes->value(seats[index]);
+        result.engine = attributes->value(engine[index]);
+        result.tripComputer = attributes->value(tripComputer[index]);
+        result.gps = attributes->value(gps[index]);
+        return result;
+    }
+
+    std::size_t countWithEngine(const std::string& value) const {
+        Code wanted;
+        if (!attributes->find(value, wanted)) {
+            return 0;
+        }
+        std::size_t count = 0;
+        for (Code code : engine) {
+            count += code == wanted;
+        }
+        return count;
+    }
+};
+
+// The 'Builder' abstract class for batches
+class CarBatchBuilder {
+public:
+    virtual ~CarBatchBuilder() {}
+    virtual void reserve(std::size_t count) = 0;
+    virtual void buildSeats() = 0;
+    virtual void buildEngine() = 0;
+    virtual void buildTripComputer() = 0;
+    virtual void buildGPS() = 0;
+    // Appends the car assembled by the build steps to the batch
+    virtual void commit() = 0;
+    virtual CarBatch getBatch() = 0;
+};
+
+// The 'ConcreteBuilder' class for batches; parts are interned once up front,
+// so each build step only stores a code
+class ConcreteCarBatchBuilder : public CarBatchBuilder {
+private:
+    std::shared_ptr<AttributePool> attributes = std::make_shared<AttributePool>();
+    CarBatch batch{attributes};
+    CarBatch::Row row;
+    CarBatch::Code leather = attributes->intern("Leather");
+    CarBatch::Code v8 = attributes->intern("V8");
+    CarBatch::Code highEnd = attributes->intern("High-end");
+    CarBatch::Code builtIn = attributes->intern("Built-in");
+
+public:
+    void reserve(std::size_t count) override {
+        batch.reserve(count);
+    }
+
+    void buildSeats() override {
+        row.seats = leather;
+    }
+
+    void buildEngine() override {
+        row.engine = v8;
+    }
+
+    void buildTripComputer() override {
+        row.tripComputer = highEnd;
+    }
+
+    void buildGPS() override {
+        row.gps = builtIn;
+    }
+
+    void commit() override {
+        batch.append(row);
+        row = CarBatch::Row();
+    }
+
+    CarBatch getBatch() override {
+        CarBatch built = std::move(batch);
+        batch = CarBatch(attributes);
+        return built;
     }
 };
 
@@ -97,6 +273,17 @@ public:
         builder.buildTripComputer();
         builder.buildGPS();
     }
+
+    void constructSportsCars(CarBatchBuilder& builder, std::size_t count) {
+        builder.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            builder.buildSeats();
+            builder.buildEngine();
+            builder.buildTripComputer();
+            builder.buildGPS();
+            builder.commit();
+        }
+    }
 };
 
 // Client code
@@ -107,6 +294,18 @@ int main() {
     
     Car car = builder.getCar();
     car.specifications();
-    
+
+    // Build a whole batch in one call
+    const std::size_t count = 1000000;
+    ConcreteCarBatchBuilder batchBuilder;
+    auto start = std::chrono::steady_clock::now();
+    director.constructSportsCars(batchBuilder, count);
+    CarBatch batch = batchBuilder.getBatch();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Batch of " << batch.size() << " cars (" << batch.countWithEngine("V8") << " V8) at "
+              << static_cast<long>(batch.size() / elapsed.count()) << " cars/s, "
+              << CarBatch::bytesPerCar() << " bytes per car instead of " << sizeof(Car) << std::endl;
+    batch.car(count - 1).specifications();
+
     return 0;
 }
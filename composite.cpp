@@ -1,7 +1,24 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <list>
+#include <stdexcept>
+#include <streambuf>
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "forkjoinpool.h"
 
 /*
 The Composite design pattern is used to treat individual objects and compositions of objects 
@@ -14,10 +31,325 @@ Key Elements of the Composite Pattern:
 - Client: Manipulates objects in the composition through the Component interface.
 */
 
+// FlatTree - the same hierarchy laid out as a flat arena in DFS order.
+// Each attribute is its own column, children are reached through index
+// links, and every subtree occupies the contiguous range [node, subtreeEnd),
+// so whole-tree operations become linear scans instead of pointer chasing.
+class FlatTree {
+public:
+    enum class Kind : std::uint8_t { Leaf, Composite };
+
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+private:
+    std::string nameBytes;
+    std::vector<std::uint32_t> nameOffset;
+    std::vector<std::uint32_t> nameLength;
+    std::vector<Kind> kinds;
+    std::vector<double> costs;
+    std::vector<std::uint32_t> depths;
+    std::vector<std::uint32_t> firstChildren;
+    std::vector<std::uint32_t> nextSiblings;
+    std::vector<std::uint32_t> subtreeEnds;
+
+    // Composites still being filled during construction, with their last child
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> open;
+
+    std::uint32_t push(std::string_view name, Kind kind, double cost) {
+        std::uint32_t index = static_cast<std::uint32_t>(kinds.size());
+        if (!open.empty()) {
+            auto &parent = open.back();
+            if (parent.second == none) {
+                firstChildren[parent.first] = index;
+            } else {
+                nextSiblings[parent.second] = index;
+            }
+            parent.second = index;
+        }
+        nameOffset.push_back(static_cast<std::uint32_t>(nameBytes.size()));
+        nameLength.push_back(static_cast<std::uint32_t>(name.size()));
+        nameBytes += name;
+        kinds.push_back(kind);
+        costs.push_back(cost);
+        depths.push_back(static_cast<std::uint32_t>(open.size()));
+        firstChildren.push_back(none);
+        nextSiblings.push_back(none);
+        subtreeEnds.push_back(index + 1);
+        return index;
+    }
+
+public:
+    // Construction must follow DFS order: a composite's children are added
+    // between its openComposite and closeComposite calls
+    std::uint32_t addLeaf(std::string_view name, double cost = 0.0) {
+        return push(name, Kind::Leaf, cost);
+    }
+
+    std::uint32_t openComposite(std::string_view name) {
+        std::uint32_t index = push(name, Kind::Composite, 0.0);
+        open.emplace_back(index, none);
+        return index;
+    }
+
+    void closeComposite() {
+        subtreeEnds[open.back().first] = static_cast<std::uint32_t>(kinds.size());
+        open.pop_back();
+    }
+
+    std::size_t size() const { return kinds.size(); }
+    std::string_view name(std::uint32_t node) const {
+        return std::string_view(nameBytes).substr(nameOffset[node], nameLength[node]);
+    }
+    Kind kind(std::uint32_t node) const { return kinds[node]; }
+    double cost(std::uint32_t node) const { return costs[node]; }
+    std::uint32_t firstChild(std::uint32_t node) const { return firstChildren[node]; }
+    std::uint32_t nextSibling(std::uint32_t node) const { return nextSiblings[node]; }
+    std::uint32_t subtreeEnd(std::uint32_t node) const { return subtreeEnds[node]; }
+
+    // Same output as Component::display, produced by one forward scan
+    void display(int depth) const {
+        for (std::size_t i = 0; i < kinds.size(); ++i) {
+            char marker = kinds[i] == Kind::Composite ? '+' : '-';
+            std::cout << std::string(depth + 2 * depths[i], marker) << name(i) << std::endl;
+        }
+    }
+
+    std::size_t countLeaves(std::uint32_t node = 0) const {
+        std::size_t count = 0;
+        for (std::uint32_t i = node; i < subtreeEnds[node]; ++i) {
+            count += kinds[i] == Kind::Leaf;
+        }
+        return count;
+    }
+
+    // Writes the tree in the flat file format read back by MappedTree
+    void save(const std::string& path) const;
+};
+
+// On-disk layout of a FlatTree, in native byte order:
+//   TreeFileHeader | TreeFileNode[nodeCount] | name bytes[stringBytes]
+// Nodes are in DFS order and a node's subtree is [index, subtreeEnd), so a
+// mapped file can be walked in place exactly like the in-memory arena.
+struct TreeFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t nodeCount;
+    std::uint64_t stringBytes;
+};
+
+struct TreeFileNode {
+    double cost;
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint32_t firstChild;
+    std::uint32_t nextSibling;
+    std::uint32_t subtreeEnd;
+    std::uint32_t depth;
+    FlatTree::Kind kind;
+    std::uint8_t padding[7];
+};
+
+constexpr char treeFileMagic[8] = {'C', 'M', 'P', 'T', 'R', 'E', 'E', '\0'};
+constexpr std::uint32_t treeFileVersion = 1;
+
+// MappedTree - read-only view of a tree file mapped into memory. Opening it
+// costs one mmap and a check of the header against the file size; each node
+// record is checked against the file's bounds when it is read, and verify()
+// checks them all up front. Nothing is copied or allocated per node, and the
+// pages are only faulted in as the tree is walked.
+class MappedTree {
+private:
+    const char* base = nullptr;
+    std::size_t length = 0;
+    const TreeFileNode* nodes = nullptr;
+    const char* names = nullptr;
+    std::uint32_t count = 0;
+    std::uint64_t stringBytes = 0;
+
+    // Every link must stay inside the tree and point forward, as in DFS order
+    bool validNode(std::uint32_t i) const {
+        const TreeFileNode& node = nodes[i];
+        bool leaf = node.kind == FlatTree::Kind::Leaf;
+        return (leaf || node.kind == FlatTree::Kind::Composite) &&
+               std::uint64_t{node.nameOffset} + node.nameLength <= stringBytes &&
+               node.subtreeEnd > i && node.subtreeEnd <= count &&
+               node.depth < count &&
+               (node.firstChild == FlatTree::none || (node.firstChild == i + 1 && node.subtreeEnd > i + 1)) &&
+               (node.nextSibling == FlatTree::none || (node.nextSibling == node.subtreeEnd && node.nextSibling < count)) &&
+               (!leaf || (node.firstChild == FlatTree::none && node.subtreeEnd == i + 1));
+    }
+
+    const TreeFileNode& record(std::uint32_t i) const {
+        if (i >= count || !validNode(i)) {
+            throw std::runtime_error("corrupt tree node " + std::to_string(i));
+        }
+        return nodes[i];
+    }
+
+public:
+    explicit MappedTree(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open tree file: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(TreeFileHeader)) {
+            ::close(fd);
+            throw std::runtime_error("not a tree file: " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            throw std::runtime_error("cannot map tree file: " + path);
+        }
+        base = static_cast<const char*>(address);
+
+        TreeFileHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        std::uint64_t available = length - sizeof(header);
+        std::uint64_t nodeBytes = std::uint64_t{header.nodeCount} * sizeof(TreeFileNode);
+        if (std::memcmp(header.magic, treeFileMagic, sizeof(treeFileMagic)) != 0 ||
+            header.version != treeFileVersion || nodeBytes > available ||
+            header.stringBytes != available - nodeBytes) {
+            ::munmap(const_cast<char*>(base), length);
+            throw std::runtime_error("corrupt tree file: " + path);
+        }
+        count = header.nodeCount;
+        stringBytes = header.stringBytes;
+        nodes = reinterpret_cast<const TreeFileNode*>(base + sizeof(header));
+        names = base + sizeof(header) + nodeBytes;
+    }
+
+    ~MappedTree() {
+        ::munmap(const_cast<char*>(base), length);
+    }
+
+    MappedTree(const MappedTree&) = delete;
+    MappedTree& operator=(const MappedTree&) = delete;
+
+    // Checks every node record, touching the whole node array once
+    void verify() const {
+        for (std::uint32_t i = 0; i < count; ++i) {
+            record(i);
+        }
+    }
+
+    std::size_t size() const { return count; }
+    std::string_view name(std::uint32_t node) const {
+        const TreeFileNode& entry = record(node);
+        return std::string_view(names + entry.nameOffset, entry.nameLength);
+    }
+    FlatTree::Kind kind(std::uint32_t node) const { return record(node).kind; }
+    double cost(std::uint32_t node) const { return record(node).cost; }
+    std::uint32_t depth(std::uint32_t node) const { return record(node).depth; }
+    std::uint32_t firstChild(std::uint32_t node) const { return record(node).firstChild; }
+    std::uint32_t nextSibling(std::uint32_t node) const { return record(node).nextSibling; }
+    std::uint32_t subtreeEnd(std::uint32_t node) const { return record(node).subtreeEnd; }
+
+    void display(int depth) const {
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const TreeFileNode& entry = record(i);
+            char marker = entry.kind == FlatTree::Kind::Composite ? '+' : '-';
+            std::cout << std::string(depth + 2 * entry.depth, marker)
+                      << std::string_view(names + entry.nameOffset, entry.nameLength) << std::endl;
+        }
+    }
+};
+
+inline void FlatTree::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    TreeFileHeader header{};
+    std::memcpy(header.magic, treeFileMagic, sizeof(treeFileMagic));
+    header.version = treeFileVersion;
+    header.nodeCount = static_cast<std::uint32_t>(size());
+    header.stringBytes = nameBytes.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<TreeFileNode> records(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        records[i] = TreeFileNode{costs[i], nameOffset[i], nameLength[i], firstChildren[i],
+                                  nextSiblings[i], subtreeEnds[i], depths[i], kinds[i], {}};
+    }
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TreeFileNode));
+    out.write(nameBytes.data(), nameBytes.size());
+    if (!out) {
+        throw std::runtime_error("cannot write tree file: " + path);
+    }
+}
+
+// Rolls a value up over all leaves of the subtree rooted at `node`.
+// A subtree is a contiguous DFS range, so it is split into halves until the
+// pieces reach `grain` nodes; smaller ranges are folded sequentially.
+// `combine` must be associative; left-to-right order is preserved, so it
+// does not need to be commutative.
+template <typename T, typename LeafValue, typename Combine>
+T reduceLeaves(ForkJoinPool& pool, const FlatTree& tree, std::uint32_t begin, std::uint32_t end,
+               const T& identity, const LeafValue& leafValue, const Combine& combine,
+               std::size_t grain) {
+    if (end - begin <= grain) {
+        T result = identity;
+        for (std::uint32_t i = begin; i < end; ++i) {
+            if (tree.kind(i) == FlatTree::Kind::Leaf) {
+                result = combine(result, leafValue(tree, i));
+            }
+        }
+        return result;
+    }
+    std::uint32_t middle = begin + (end - begin) / 2;
+    T left = identity;
+    T right = identity;
+    pool.invoke(
+        [&] { left = reduceLeaves(pool, tree, begin, middle, identity, leafValue, combine, grain); },
+        [&] { right = reduceLeaves(pool, tree, middle, end, identity, leafValue, combine, grain); });
+    return combine(left, right);
+}
+
+template <typename T, typename LeafValue, typename Combine>
+T parallelReduce(ForkJoinPool& pool, const FlatTree& tree, std::uint32_t node, T identity,
+                 LeafValue leafValue, Combine combine, std::size_t grain = 16384) {
+    T result = identity;
+    pool.run([&] {
+        result = reduceLeaves(pool, tree, node, tree.subtreeEnd(node), identity, leafValue,
+                              combine, std::max<std::size_t>(grain, 1));
+    });
+    return result;
+}
+
 // The 'Component' class
 class Component {
+public:
+    // Aggregates over the subtree rooted at a component, kept up to date
+    // incrementally so reading them never walks the tree
+    struct Totals {
+        std::size_t nodes = 0;
+        std::size_t leaves = 0;
+        double cost = 0.0;
+    };
+
 protected:
+    friend class Composite;
+
     std::string name;
+    Component* parent = nullptr;    // cleared by the parent's destructor
+    std::list<std::shared_ptr<Component>>::iterator positionInParent;
+    Totals totals;
+
+    // Adds or subtracts a child subtree's totals on this node and every
+    // ancestor, O(depth)
+    void propagate(const Totals& delta, bool added) {
+        for (Component* node = this; node; node = node->parent) {
+            if (added) {
+                node->totals.nodes += delta.nodes;
+                node->totals.leaves += delta.leaves;
+                node->totals.cost += delta.cost;
+            } else {
+                node->totals.nodes -= delta.nodes;
+                node->totals.leaves -= delta.leaves;
+                node->totals.cost -= delta.cost;
+            }
+        }
+    }
 
 public:
     explicit Component(std::string name) : name(std::move(name)) {}
@@ -26,32 +358,87 @@ public:
     virtual void add(std::shared_ptr<Component> component) {}
     virtual void remove(std::shared_ptr<Component> component) {}
     virtual void display(int depth) const = 0;
+    virtual void flattenInto(FlatTree& tree) const = 0;
+    // Walks the subtree; subtreeTotals() has the same count cached
+    virtual std::size_t countLeaves() const = 0;
+
+    const Totals& subtreeTotals() const {
+        return totals;
+    }
+
+    FlatTree flatten() const {
+        FlatTree tree;
+        flattenInto(tree);
+        return tree;
+    }
 };
 
 // The 'Leaf' class 
 class Leaf : public Component {
+private:
+    double cost;
+
 public:
-    using Component::Component;
+    explicit Leaf(std::string name, double cost = 0.0) : Component(std::move(name)), cost(cost) {
+        totals = Totals{1, 1, cost};
+    }
 
     void display(int depth) const override {
         std::cout << std::string(depth, '-') << name << std::endl;
     }
+
+    void flattenInto(FlatTree& tree) const override {
+        tree.addLeaf(name, cost);
+    }
+
+    std::size_t countLeaves() const override {
+        return 1;
+    }
 };
 
 // The 'Composite' class
 class Composite : public Component {
 private:
-    std::vector<std::shared_ptr<Component>> children;
+    // A list, so each child can keep its own position and be removed in
+    // O(1) without reordering its siblings
+    std::list<std::shared_ptr<Component>> children;
 
 public:
-    using Component::Component;
+    explicit Composite(std::string name) : Component(std::move(name)) {
+        totals = Totals{1, 0, 0.0};
+    }
 
+    // Children may outlive this composite through other shared_ptrs
+    ~Composite() override {
+        for (const auto& child : children) {
+            child->parent = nullptr;
+        }
+    }
+
+    // Moves `component` here from its current parent, if any. Adding this
+    // composite or one of its ancestors would create a cycle and throws.
     void add(std::shared_ptr<Component> component) override {
-        children.push_back(component);
+        for (const Component* node = this; node; node = node->parent) {
+            if (node == component.get()) {
+                throw std::invalid_argument("cannot add a component to its own subtree");
+            }
+        }
+        if (component->parent) {
+            component->parent->remove(component);
+        }
+        Component& child = *component;
+        child.parent = this;
+        child.positionInParent = children.insert(children.end(), std::move(component));
+        propagate(child.totals, true);
     }
 
     void remove(std::shared_ptr<Component> component) override {
-        // Code to remove the component from the children
+        if (component->parent != this) {
+            return;
+        }
+        children.erase(component->positionInParent);
+        component->parent = nullptr;
+        propagate(component->totals, false);
     }
 
     void display(int depth) const override {
@@ -60,6 +447,83 @@ public:
             child->display(depth + 2);
         }
     }
+
+    void flattenInto(FlatTree& tree) const override {
+        tree.openComposite(name);
+        for (const auto& child : children) {
+            child->flattenInto(tree);
+        }
+        tree.closeComposite();
+    }
+
+    std::size_t countLeaves() const override {
+        std::size_t count = 0;
+        for (const auto& child : children) {
+            count += child->countLeaves();
+        }
+        return count;
+    }
+};
+
+// Builds a root holding `composites` composites of `leaves` leaves each
+std::shared_ptr<Composite> buildWideTree(std::size_t composites, std::size_t leaves) {
+    auto root = std::make_shared<Composite>("root");
+    for (std::size_t i = 0; i < composites; ++i) {
+        auto group = std::make_shared<Composite>("Composite " + std::to_string(i));
+        for (std::size_t j = 0; j < leaves; ++j) {
+            group->add(std::make_shared<Leaf>("Leaf " + std::to_string(j), 1.0));
+        }
+        root->add(group);
+    }
+    return root;
+}
+
+// Rebuilds the object graph from a tree file node by node: what loading
+// costs without the mapped format
+std::shared_ptr<Component> rebuildObjects(const MappedTree& tree) {
+    // Composites still taking children, with the end of their subtree
+    std::vector<std::pair<std::shared_ptr<Composite>, std::uint32_t>> open;
+    std::shared_ptr<Component> root;
+    for (std::uint32_t i = 0; i < tree.size(); ++i) {
+        while (!open.empty() && open.back().second <= i) {
+            open.pop_back();
+        }
+        std::shared_ptr<Composite> composite;
+        std::shared_ptr<Component> node;
+        if (tree.kind(i) == FlatTree::Kind::Composite) {
+            composite = std::make_shared<Composite>(std::string(tree.name(i)));
+            node = composite;
+        } else {
+            node = std::make_shared<Leaf>(std::string(tree.name(i)), tree.cost(i));
+        }
+        if (!open.empty()) {
+            open.back().first->add(node);
+        } else if (!root) {
+            root = node;
+        } else {
+            throw std::runtime_error("tree file has more than one root");
+        }
+        if (composite) {
+            open.emplace_back(std::move(composite), tree.subtreeEnd(i));
+        }
+    }
+    return root;
+}
+
+// Wall time of one run of `job`, in milliseconds
+template <typename F>
+double millisecondsFor(F&& job) {
+    auto start = std::chrono::steady_clock::now();
+    job();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Swallows output, so display() can be timed without the terminal
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
 };
 
 // Client code
@@ -68,12 +532,12 @@ int main() {
     auto root2 = std::make_shared<Composite>("root2");
     root2->add(std::make_shared<Leaf>("Leaf root2A"));
     root->add(root2);
-    root->add(std::make_shared<Leaf>("Leaf A"));
-    root->add(std::make_shared<Leaf>("Leaf B"));
+    root->add(std::make_shared<Leaf>("Leaf A", 1.5));
+    root->add(std::make_shared<Leaf>("Leaf B", 2.0));
 
     auto comp = std::make_shared<Composite>("Composite X");
-    comp->add(std::make_shared<Leaf>("Leaf XA"));
-    comp->add(std::make_shared<Leaf>("Leaf XB"));
+    comp->add(std::make_shared<Leaf>("Leaf XA", 4.0));
+    comp->add(std::make_shared<Leaf>("Leaf XB", 0.5));
 
     root->add(comp);
     root->add(std::make_shared<Leaf>("Leaf C"));
@@ -84,5 +548,119 @@ int main() {
 
     root->display(1);
 
+    const Component::Totals& totals = root->subtreeTotals();
+    std::cout << "Cached totals: " << totals.nodes << " nodes, " << totals.leaves
+              << " leaves, cost " << totals.cost << std::endl;
+
+    // The same tree as a flat arena, displayed by a linear scan
+    FlatTree flat = root->flatten();
+    flat.display(1);
+    std::cout << "Leaves: " << flat.countLeaves() << std::endl;
+
+    // Aggregates rolled up in parallel with user-supplied combiners
+    ForkJoinPool pool;
+    double totalCost = parallelReduce(pool, flat, 0, 0.0,
+        [](const FlatTree& tree, std::uint32_t leaf) { return tree.cost(leaf); },
+        [](double a, double b) { return a + b; });
+    std::size_t leafCount = parallelReduce(pool, flat, 0, std::size_t{0},
+        [](const FlatTree&, std::uint32_t) { return std::size_t{1}; },
+        [](std::size_t a, std::size_t b) { return a + b; });
+    std::cout << "Total cost: " << totalCost << " over " << leafCount << " leaves" << std::endl;
+
+    // Round trip through the flat file format, traversed in place after mmap
+    flat.save("composite.tree");
+    {
+        MappedTree mapped("composite.tree");
+        mapped.display(1);
+    }
+    std::remove("composite.tree");
+
+    // Whole-tree traversals: pointer-linked objects against the flat arena
+    {
+        auto graph = buildWideTree(1000, 1000);
+        FlatTree arena = graph->flatten();
+        std::size_t graphLeaves = 0;
+        std::size_t arenaLeaves = 0;
+        double graphCount = millisecondsFor([&] { graphLeaves = graph->countLeaves(); });
+        double arenaCount = millisecondsFor([&] { arenaLeaves = arena.countLeaves(); });
+        NullBuffer discard;
+        std::streambuf* terminal = std::cout.rdbuf(&discard);
+        double graphDisplay = millisecondsFor([&] { graph->display(1); });
+        double arenaDisplay = millisecondsFor([&] { arena.display(1); });
+        std::cout.rdbuf(terminal);
+        std::cout << arena.size() << " nodes, countLeaves: objects " << graphCount << " ms, arena " << arenaCount
+                  << " ms (" << graphLeaves << " = " << arenaLeaves << "); display: objects " << graphDisplay
+                  << " ms, arena " << arenaDisplay << " ms" << std::endl;
+    }
+
+    // parallelReduce splits leaf ranges, not children, so a chain one
+    // composite deep per leaf should scale like a wide tree does
+    {
+        FlatTree wide = buildWideTree(1000, 1000)->flatten();
+        FlatTree deep;
+        for (std::size_t i = 0; i < 1000000; ++i) {
+            deep.openComposite("Composite");
+            deep.addLeaf("Leaf", 1.0);
+        }
+        for (std::size_t i = 0; i < 1000000; ++i) {
+            deep.closeComposite();
+        }
+        ForkJoinPool single(1);
+        for (const auto& [shape, tree] : {std::pair<const char*, const FlatTree*>{"wide", &wide},
+                                          std::pair<const char*, const FlatTree*>{"deep", &deep}}) {
+            auto sumCosts = [tree = tree](ForkJoinPool& on) {
+                return parallelReduce(on, *tree, 0, 0.0,
+                    [](const FlatTree& t, std::uint32_t leaf) { return t.cost(leaf); },
+                    [](double a, double b) { return a + b; });
+            };
+            double sequentialSum = 0.0;
+            double parallelSum = 0.0;
+            double sequential = millisecondsFor([&] { sequentialSum = sumCosts(single); });
+            double parallel = millisecondsFor([&] { parallelSum = sumCosts(pool); });
+            std::cout << shape << " tree, " << tree->size() << " nodes: parallelReduce 1 thread "
+                      << sequential << " ms, " << pool.size() << " threads " << parallel << " ms ("
+                      << sequentialSum << " = " << parallelSum << ")" << std::endl;
+        }
+    }
+
+    // Churn: children removed from the middle of a large composite and added
+    // back, each one unlinking in O(1) and updating two ancestors' totals
+    {
+        auto top = std::make_shared<Composite>("top");
+        auto group = std::make_shared<Composite>("group");
+        top->add(group);
+        std::vector<std::shared_ptr<Component>> members;
+        for (std::size_t i = 0; i < 100000; ++i) {
+            members.push_back(std::make_shared<Leaf>("Leaf " + std::to_string(i), 1.0));
+            group->add(members.back());
+        }
+        const std::size_t operations = 4000000;
+        double elapsed = millisecondsFor([&] {
+            for (std::size_t i = 0; i < operations / 2; ++i) {
+                const auto& member = members[(i * 7919) % members.size()];
+                group->remove(member);
+                group->add(member);
+            }
+        });
+        std::cout << operations << " add/remove on " << members.size() << " children: " << elapsed
+                  << " ms (" << elapsed * 1e6 / operations << " ns/op), totals "
+                  << top->subtreeTotals().leaves << " leaves" << std::endl;
+    }
+
+    // Loading a saved tree: mapping it in place against rebuilding the objects
+    {
+        buildWideTree(1000, 1000)->flatten().save("composite.tree");
+        std::unique_ptr<MappedTree> mapped;
+        double open = millisecondsFor([&] { mapped = std::make_unique<MappedTree>("composite.tree"); });
+        double verify = millisecondsFor([&] { mapped->verify(); });
+        std::shared_ptr<Component> rebuilt;
+        double rebuild = millisecondsFor([&] { rebuilt = rebuildObjects(*mapped); });
+        std::cout << mapped->size() << " nodes loaded: mmap " << open << " ms, verify " << verify
+                  << " ms; rebuilding objects " << rebuild << " ms (" << rebuilt->subtreeTotals().leaves
+                  << " leaves)" << std::endl;
+        mapped.reset();
+        std::remove("composite.tree");
+    }
+
     return 0;
 }
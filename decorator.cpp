@@ -1,6 +1,14 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /*
 The Decorator design pattern dynamically adds additional responsibilities to an object. It provides a 
@@ -15,17 +23,27 @@ Key Elements:
 */
 
 // 'Component' Interface
+// Results are appended into a caller-supplied buffer: each layer writes its
+// prefix, lets the inner component append, then writes its suffix. A stack
+// of any depth therefore fills one string in a single pass with no
+// temporaries; a caller reusing its buffer pays no allocation at all.
 class Component {
 public:
     virtual ~Component() {}
-    virtual std::string operation() const = 0;
+    virtual void appendOperation(std::string& out) const = 0;
+
+    std::string operation() const {
+        std::string out;
+        appendOperation(out);
+        return out;
+    }
 };
 
 // 'ConcreteComponent' Class
-class ConcreteComponent : public Component {
+class ConcreteComponent final : public Component {
 public:
-    std::string operation() const override {
-        return "ConcreteComponent";
+    void appendOperation(std::string& out) const override {
+        out += "ConcreteComponent";
     }
 };
 
@@ -35,8 +53,8 @@ protected:
     std::shared_ptr<Component> component;
 public:
     Decorator(std::shared_ptr<Component> component) : component(component) {}
-    std::string operation() const override {
-        return component->operation();
+    void appendOperation(std::string& out) const override {
+        component->appendOperation(out);
     }
 };
 
@@ -45,8 +63,10 @@ class ConcreteDecoratorA : public Decorator {
 public:
     ConcreteDecoratorA(std::shared_ptr<Component> component) : Decorator(component) {}
 
-    std::string operation() const override {
-        return "ConcreteDecoratorA(" + Decorator::operation() + ")";
+    void appendOperation(std::string& out) const override {
+        out += "ConcreteDecoratorA(";
+        Decorator::appendOperation(out);
+        out += ")";
     }
 };
 
@@ -55,13 +75,359 @@ class ConcreteDecoratorB : public Decorator {
 public:
     ConcreteDecoratorB(std::shared_ptr<Component> component) : Decorator(component) {}
 
+    void appendOperation(std::string& out) const override {
+        out += "ConcreteDecoratorB(";
+        Decorator::appendOperation(out);
+        out += ")";
+    }
+};
+
+// Compile-time decorator stacks. When a chain is fixed at build time each
+// layer can hold the inner one by value, so every call below is statically
+// dispatched and the optimizer can inline the whole stack.
+
+// Decorations describe only the text a layer adds around its inner result
+struct DecorationA {
+    static constexpr std::string_view prefix = "ConcreteDecoratorA(";
+    static constexpr std::string_view suffix = ")";
+};
+
+struct DecorationB {
+    static constexpr std::string_view prefix = "ConcreteDecoratorB(";
+    static constexpr std::string_view suffix = ")";
+};
+
+template <typename Inner, typename Decoration>
+class StaticDecorator {
+private:
+    Inner inner;
+
+public:
+    void appendOperation(std::string& out) const {
+        out += Decoration::prefix;
+        inner.appendOperation(out);
+        out += Decoration::suffix;
+    }
+
+    std::string operation() const {
+        std::string out;
+        appendOperation(out);
+        return out;
+    }
+};
+
+template <typename Base, typename... Decorations>
+struct DecoratedStack {
+    using type = Base;
+};
+
+template <typename Base, typename First, typename... Rest>
+struct DecoratedStack<Base, First, Rest...> {
+    using type = typename DecoratedStack<StaticDecorator<Base, First>, Rest...>::type;
+};
+
+// Decorated<Base, A, B> is the static equivalent of B(A(Base)): the first
+// decoration listed is the innermost one
+template <typename Base, typename... Decorations>
+using Decorated = typename DecoratedStack<Base, Decorations...>::type;
+
+// Exposes a static stack through the dynamic 'Component' interface
+template <typename Stack>
+class StaticComponent final : public Component {
+private:
+    Stack stack;
+
+public:
+    void appendOperation(std::string& out) const override {
+        stack.appendOperation(out);
+    }
+};
+
+// Byte stream decorators. The same structure applied to I/O: a ByteSource
+// is the component and every layer wraps another source. Slices are
+// borrowed, not copied: a layer hands out a read-only view of its own (or
+// its inner layer's) buffer that stays valid until its next read(). A layer
+// that transforms bytes writes the result into a buffer it owns.
+
+struct ByteSlice {
+    const unsigned char* data;
+    std::size_t size;
+};
+
+// 'Component' Interface for streams
+class ByteSource {
+public:
+    virtual ~ByteSource() {}
+    // Returns the next slice of the stream; an empty slice means the end
+    virtual ByteSlice read() = 0;
+};
+
+// 'ConcreteComponent' reading a file in large chunks into one reused buffer
+class FileSource : public ByteSource {
+private:
+    std::FILE* file;
+    std::vector<unsigned char> buffer;
+
+public:
+    explicit FileSource(const std::string& path, std::size_t chunkSize = 1 << 20)
+        : file(std::fopen(path.c_str(), "rb")), buffer(chunkSize) {
+        if (!file) {
+            throw std::runtime_error("cannot open " + path);
+        }
+    }
+
+    ~FileSource() override {
+        std::fclose(file);
+    }
+
+    FileSource(const FileSource&) = delete;
+    FileSource& operator=(const FileSource&) = delete;
+
+    ByteSlice read() override {
+        std::size_t count = std::fread(buffer.data(), 1, buffer.size(), file);
+        if (count < buffer.size() && std::ferror(file)) {
+            throw std::runtime_error("error reading file");
+        }
+        return ByteSlice{buffer.data(), count};
+    }
+};
+
+// 'ConcreteComponent' serving an in-memory buffer in fixed-size slices
+class MemorySource : public ByteSource {
+private:
+    std::vector<unsigned char> bytes;
+    std::size_t sliceSize;
+    std::size_t position = 0;
+
+public:
+    MemorySource(std::string_view text, std::size_t sliceSize)
+        : bytes(text.begin(), text.end()), sliceSize(std::max<std::size_t>(sliceSize, 1)) {}
+
+    ByteSlice read() override {
+        std::size_t count = std::min(sliceSize, bytes.size() - position);
+        ByteSlice slice{bytes.data() + position, count};
+        position += count;
+        return slice;
+    }
+};
+
+// 'Decorator' for streams
+class SourceDecorator : public ByteSource {
+protected:
+    std::shared_ptr<ByteSource> source;
+public:
+    SourceDecorator(std::shared_ptr<ByteSource> source) : source(source) {}
+    ByteSlice read() override {
+        return source->read();
+    }
+};
+
+// Counts bytes and slices passing through
+class MeteringSource : public SourceDecorator {
+private:
+    std::uint64_t bytes = 0;
+    std::uint64_t slices = 0;
+
+public:
+    MeteringSource(std::shared_ptr<ByteSource> source) : SourceDecorator(source) {}
+
+    ByteSlice read() override {
+        ByteSlice slice = SourceDecorator::read();
+        bytes += slice.size;
+        slices += slice.size != 0;
+        return slice;
+    }
+
+    std::uint64_t byteCount() const { return bytes; }
+    std::uint64_t sliceCount() const { return slices; }
+};
+
+// Adler-32 of everything read. Each block is summed with a plain and a
+// position-weighted accumulation, which has no loop-carried dependency
+// between bytes, so the compiler can vectorize it.
+class ChecksumSource : public SourceDecorator {
+private:
+    static constexpr std::uint32_t modulus = 65521;
+    // Largest block whose weighted sum cannot overflow 32 bits
+    static constexpr std::size_t blockLimit = 5552;
+
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+
+    void update(const unsigned char* data, std::size_t size) {
+        while (size > 0) {
+            std::size_t n = std::min(size, blockLimit);
+            std::uint32_t sum = 0;
+            std::uint32_t weighted = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += data[i];
+                weighted += static_cast<std::uint32_t>(n - i) * data[i];
+            }
+            b = static_cast<std::uint32_t>((b + static_cast<std::uint64_t>(n) * a + weighted) % modulus);
+            a = (a + sum) % modulus;
+            data += n;
+            size -= n;
+        }
+    }
+
+public:
+    ChecksumSource(std::shared_ptr<ByteSource> source) : SourceDecorator(source) {}
+
+    ByteSlice read() override {
+        ByteSlice slice = SourceDecorator::read();
+        update(slice.data, slice.size);
+        return slice;
+    }
+
+    std::uint32_t checksum() const {
+        return (b << 16) | a;
+    }
+};
+
+// Stand-in for encryption: XORs the stream with a repeating 8-byte key, a
+// whole word at a time, into its own output buffer
+class XorCipherSource : public SourceDecorator {
+private:
+    std::uint64_t key;
+    std::uint64_t position = 0;
+    std::vector<unsigned char> output;
+
+public:
+    XorCipherSource(std::shared_ptr<ByteSource> source, std::uint64_t key)
+        : SourceDecorator(source), key(key) {}
+
+    ByteSlice read() override {
+        ByteSlice slice = SourceDecorator::read();
+        // Rotate the key so its first byte lines up with the slice start
+        unsigned shift = 8 * (position % 8);
+        std::uint64_t aligned = shift ? (key >> shift) | (key << (64 - shift)) : key;
+        output.resize(slice.size);
+        unsigned char* data = output.data();
+        std::size_t words = slice.size / 8;
+        for (std::size_t i = 0; i < words; ++i) {
+            std::uint64_t word;
+            std::memcpy(&word, slice.data + 8 * i, 8);
+            word ^= aligned;
+            std::memcpy(data + 8 * i, &word, 8);
+        }
+        for (std::size_t i = 8 * words; i < slice.size; ++i) {
+            data[i] = slice.data[i] ^ static_cast<unsigned char>(aligned >> (8 * (i % 8)));
+        }
+        position += slice.size;
+        return ByteSlice{data, slice.size};
+    }
+};
+
+// Regroups the stream into blocks of `blockSize` bytes (the last may be
+// shorter). Small slices are gathered into an owned block; an inner slice
+// that already covers a whole block is passed through without copying.
+class BlockBufferingSource : public SourceDecorator {
+private:
+    std::vector<unsigned char> block;
+    std::size_t blockSize;
+    ByteSlice pending{nullptr, 0};   // unconsumed rest of the last inner slice
+
+public:
+    BlockBufferingSource(std::shared_ptr<ByteSource> source, std::size_t blockSize)
+        : SourceDecorator(source), blockSize(std::max<std::size_t>(blockSize, 1)) {
+        block.reserve(this->blockSize);
+    }
+
+    ByteSlice read() override {
+        block.clear();
+        while (block.size() < blockSize) {
+            if (pending.size == 0) {
+                pending = SourceDecorator::read();
+                if (pending.size == 0) {
+                    break;
+                }
+            }
+            if (block.empty() && pending.size >= blockSize) {
+                ByteSlice whole{pending.data, blockSize};
+                pending = ByteSlice{pending.data + blockSize, pending.size - blockSize};
+                return whole;
+            }
+            std::size_t count = std::min(blockSize - block.size(), pending.size);
+            block.insert(block.end(), pending.data, pending.data + count);
+            pending = ByteSlice{pending.data + count, pending.size - count};
+        }
+        return ByteSlice{block.data(), block.size()};
+    }
+};
+
+// Stand-in for a real codec: run-length encodes each slice into
+// (count, byte) pairs held in its own output buffer
+class RunLengthSource : public SourceDecorator {
+private:
+    std::vector<unsigned char> encoded;
+
+public:
+    RunLengthSource(std::shared_ptr<ByteSource> source) : SourceDecorator(source) {}
+
+    ByteSlice read() override {
+        ByteSlice slice = SourceDecorator::read();
+        encoded.clear();
+        for (std::size_t i = 0; i < slice.size;) {
+            std::size_t run = 1;
+            while (i + run < slice.size && run < 255 && slice.data[i + run] == slice.data[i]) {
+                ++run;
+            }
+            encoded.push_back(static_cast<unsigned char>(run));
+            encoded.push_back(slice.data[i]);
+            i += run;
+        }
+        return ByteSlice{encoded.data(), encoded.size()};
+    }
+};
+
+// Pulls a source until it is exhausted
+inline void drain(ByteSource& source) {
+    while (source.read().size != 0) {
+    }
+}
+
+// The original protocol, kept as a baseline for the timings in main: every
+// layer returns a new string built as "X(" + inner + ")"
+class ConcatComponent {
+public:
+    virtual ~ConcatComponent() {}
+    virtual std::string operation() const = 0;
+};
+
+class ConcatConcreteComponent final : public ConcatComponent {
+public:
+    std::string operation() const override {
+        return "ConcreteComponent";
+    }
+};
+
+class ConcatDecorator final : public ConcatComponent {
+private:
+    std::shared_ptr<ConcatComponent> component;
+    const char* label;
+
+public:
+    ConcatDecorator(std::shared_ptr<ConcatComponent> component, const char* label)
+        : component(std::move(component)), label(label) {}
+
     std::string operation() const override {
-        return "ConcreteDecoratorB(" + Decorator::operation() + ")";
+        return std::string(label) + "(" + component->operation() + ")";
     }
 };
 
+// Average wall time of one call to `job`, in nanoseconds
+template <typename F>
+double nanosecondsPerCall(std::size_t iterations, F&& job) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        job();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
 // Client code
-int main() {
+int main(int argc, char* argv[]) {
     auto simple = std::make_shared<ConcreteComponent>();
     std::cout << "Client: I've got a simple component:\n";
     std::cout << "RESULT: " << simple->operation();
@@ -72,7 +438,84 @@ int main() {
     auto decorator2 = std::make_shared<ConcreteDecoratorB>(decorator1);
     std::cout << "Client: Now I've got a decorated component:\n";
     std::cout << "RESULT: " << decorator2->operation();
+    std::cout << "\n\n";
+
+    // Appending stays linear in the output at any depth; concatenating
+    // copies the inner result again at every layer, quadratic overall
+    std::cout << "Client: Timing operation() on deeper stacks:\n";
+    for (std::size_t depth : {1, 10, 100, 1000}) {
+        std::shared_ptr<Component> stack = simple;
+        std::shared_ptr<ConcatComponent> concatStack = std::make_shared<ConcatConcreteComponent>();
+        for (std::size_t i = 0; i < depth; ++i) {
+            if (i % 2 == 0) {
+                stack = std::make_shared<ConcreteDecoratorA>(stack);
+                concatStack = std::make_shared<ConcatDecorator>(concatStack, "ConcreteDecoratorA");
+            } else {
+                stack = std::make_shared<ConcreteDecoratorB>(stack);
+                concatStack = std::make_shared<ConcatDecorator>(concatStack, "ConcreteDecoratorB");
+            }
+        }
+        if (stack->operation() != concatStack->operation()) {
+            std::cerr << "depth " << depth << ": appended and concatenated results differ\n";
+            return 1;
+        }
+        std::size_t length = 0;
+        double appended = nanosecondsPerCall(100000 / depth, [&] { length += stack->operation().size(); });
+        double concatenated = nanosecondsPerCall(100000 / depth, [&] { length += concatStack->operation().size(); });
+        std::cout << "depth " << depth << ": append " << appended << " ns per call ("
+                  << appended / depth << " ns per layer), concatenate " << concatenated << " ns per call ("
+                  << concatenated / depth << " ns per layer), " << length << " bytes built\n";
+    }
     std::cout << "\n";
 
+    // ...and the same stack can be composed at compile time
+    using StaticStack = Decorated<ConcreteComponent, DecorationA, DecorationB>;
+    std::shared_ptr<Component> composed = std::make_shared<StaticComponent<StaticStack>>();
+    std::cout << "Client: Now I've got a statically decorated component:\n";
+    std::cout << "RESULT: " << composed->operation();
+    std::cout << "\n\n";
+
+    // Same eight layers dispatched virtually and statically, appending into
+    // one reused buffer so only the dispatch differs
+    std::shared_ptr<Component> dynamicStack = simple;
+    for (int i = 0; i < 4; ++i) {
+        dynamicStack = std::make_shared<ConcreteDecoratorB>(std::make_shared<ConcreteDecoratorA>(dynamicStack));
+    }
+    Decorated<ConcreteComponent, DecorationA, DecorationB, DecorationA, DecorationB,
+              DecorationA, DecorationB, DecorationA, DecorationB> staticStack;
+    std::string buffer;
+    double virtualCall = nanosecondsPerCall(1000000, [&] { buffer.clear(); dynamicStack->appendOperation(buffer); });
+    double staticCall = nanosecondsPerCall(1000000, [&] { buffer.clear(); staticStack.appendOperation(buffer); });
+    std::cout << "Client: Eight layers, virtual " << virtualCall << " ns vs static " << staticCall << " ns per call";
+    std::cout << "\n\n";
+
+    // Decorators can also layer behaviour onto a byte stream
+    auto memory = std::make_shared<MemorySource>("aaaabbbbbbbbcccdddddddd, decorated streams!", 5);
+    auto blocks = std::make_shared<BlockBufferingSource>(memory, 16);
+    auto checksum = std::make_shared<ChecksumSource>(blocks);
+    auto compressed = std::make_shared<RunLengthSource>(checksum);
+    auto metered = std::make_shared<MeteringSource>(compressed);
+    drain(*metered);
+    std::cout << "Client: Streamed through buffering, checksum and compression:\n";
+    std::cout << "RESULT: adler32 " << std::hex << checksum->checksum() << std::dec
+              << ", " << metered->byteCount() << " bytes out in " << metered->sliceCount() << " slices";
+    std::cout << "\n";
+
+    // Given a file, measure the end-to-end throughput of a deeper pipeline
+    if (argc > 1) try {
+        auto file = std::make_shared<FileSource>(argv[1]);
+        auto fileChecksum = std::make_shared<ChecksumSource>(std::make_shared<BlockBufferingSource>(file, 1 << 16));
+        auto fileMeter = std::make_shared<MeteringSource>(std::make_shared<XorCipherSource>(fileChecksum, 0x5DEECE66DULL));
+        auto start = std::chrono::steady_clock::now();
+        drain(*fileMeter);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "\n" << argv[1] << ": " << fileMeter->byteCount() << " bytes, adler32 " << std::hex
+                  << fileChecksum->checksum() << std::dec << ", "
+                  << fileMeter->byteCount() / elapsed.count() / 1e9 << " GB/s" << std::endl;
+    } catch (const std::exception& error) {
+        std::cerr << argv[1] << ": " << error.what() << std::endl;
+        return 1;
+    }
+
     return 0;
 }
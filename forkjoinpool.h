@@ -0,0 +1,223 @@
+#ifndef FORKJOINPOOL_H
+#define FORKJOINPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Shared by the demos that divide work across threads (composite.cpp,
+// iterator.cpp).
+
+// ForkJoinPool - a small work-stealing pool. Every worker owns a deque:
+// it pushes and pops forked tasks at the back, idle workers steal from the
+// front of the others. A worker waiting for a stolen task keeps running
+// other tasks instead of blocking, so nested fork-join never deadlocks.
+// An exception thrown by a task is captured and rethrown to whoever joins it.
+class ForkJoinPool {
+private:
+    struct Task {
+        std::function<void()> run;
+        std::atomic<bool> done{false};
+        std::exception_ptr error{};  // published by `done`
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;              // guards queued and stopping
+    std::condition_variable sleeping;
+    std::size_t queued = 0;             // tasks sitting in any deque
+    bool stopping = false;
+
+    // The pool and worker index of the calling thread, if it is a worker
+    inline static thread_local ForkJoinPool* currentPool = nullptr;
+    inline static thread_local std::size_t currentWorker = 0;
+
+    void push(std::size_t worker, Task* task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            queues[worker]->tasks.push_back(task);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            ++queued;
+        }
+        sleeping.notify_one();
+    }
+
+    Task* dequeued(Task* task) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        --queued;
+        return task;
+    }
+
+    // Takes `task` back from our own deque if no thief got to it first
+    bool unpush(std::size_t worker, Task* task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            auto& tasks = queues[worker]->tasks;
+            if (tasks.empty() || tasks.back() != task) {
+                return false;
+            }
+            tasks.pop_back();
+        }
+        dequeued(task);
+        return true;
+    }
+
+    Task* take(std::size_t worker) {
+        Task* task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            auto& tasks = queues[worker]->tasks;
+            if (!tasks.empty()) {
+                task = tasks.back();
+                tasks.pop_back();
+            }
+        }
+        for (std::size_t i = 1; !task && i < queues.size(); ++i) {
+            Queue& victim = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+            }
+        }
+        return task ? dequeued(task) : nullptr;
+    }
+
+    static void execute(Task* task) {
+        try {
+            task->run();
+        } catch (...) {
+            task->error = std::current_exception();
+        }
+        task->done.store(true, std::memory_order_release);
+    }
+
+    void workerLoop(std::size_t worker) {
+        currentPool = this;
+        currentWorker = worker;
+        while (true) {
+            if (Task* task = take(worker)) {
+                execute(task);
+                continue;
+            }
+            // Sleeps until a push; a task counted here but taken by someone
+            // else first just sends this worker round the loop again
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeping.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit ForkJoinPool(std::size_t threads = std::thread::hardware_concurrency()) {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; ++i) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers.emplace_back(&ForkJoinPool::workerLoop, this, i);
+        }
+    }
+
+    ~ForkJoinPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        sleeping.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::size_t size() const { return workers.size(); }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    // Runs `job` inside the pool and blocks the calling thread until it ends
+    template <typename F>
+    void run(F&& job) {
+        if (currentPool == this) {
+            job();
+            return;
+        }
+        std::promise<void> finished;
+        Task task{[&] {
+            struct Signal {
+                std::promise<void>& finished;
+                ~Signal() { finished.set_value(); }
+            } signal{finished};
+            job();
+        }};
+        push(0, &task);
+        finished.get_future().wait();
+        // The worker still touches `task` right after the job returns
+        while (!task.done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        if (task.error) {
+            std::rethrow_exception(task.error);
+        }
+    }
+
+    // Runs both functions, possibly in parallel; returns when both are done.
+    // If either throws, the exception is rethrown once `second` can no longer
+    // be running (the first one wins if both throw)
+    template <typename F1, typename F2>
+    void invoke(F1&& first, F2&& second) {
+        if (currentPool != this) {
+            first();
+            second();
+            return;
+        }
+        std::size_t worker = currentWorker;
+        Task task{std::forward<F2>(second)};
+        push(worker, &task);
+        std::exception_ptr error;
+        try {
+            first();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (unpush(worker, &task)) {
+            if (!error) {
+                execute(&task);
+            }
+        } else {
+            while (!task.done.load(std::memory_order_acquire)) {
+                if (Task* other = take(worker)) {
+                    execute(other);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        if (!error) {
+            error = task.error;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+#endif // FORKJOINPOOL_H
@@ -1,11 +1,65 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "forkjoinpool.h"
+
+// A borrowed run of consecutive elements, valid while the aggregate is unchanged
+template <typename T>
+struct Chunk {
+    const T* first;
+    std::size_t count;
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    std::size_t size() const { return count; }
+};
+
+// Elements per scratch buffer in batched loops: about 16 KiB worth, capped
+// at 256, so large elements do not turn a batch into a huge allocation
+template <typename T>
+constexpr std::size_t batchCapacity() {
+    return std::clamp<std::size_t>(16384 / sizeof(T), 1, 256);
+}
+
 template <typename T>
 class Iterator {
 public:
+    using value_type = T;
+
     virtual bool hasNext() = 0;
     virtual T next() = 0;
+
+    // Copies up to `count` elements into `out` and returns how many were
+    // written; 0 means the iteration is over. One virtual call per batch
+    // instead of one per element.
+    virtual std::size_t nextBatch(T* out, std::size_t count) {
+        std::size_t written = 0;
+        while (written < count && hasNext()) {
+            out[written++] = next();
+        }
+        return written;
+    }
+
     virtual ~Iterator() {}
 };
 
@@ -13,7 +67,7 @@ template <typename T>
 class ConcreteIterator : public Iterator<T> {
 private:
     std::vector<T>& data;
-    int index;
+    std::size_t index;
 public:
     ConcreteIterator(std::vector<T>& data) : data(data), index(0) {}
 
@@ -24,12 +78,146 @@ public:
     T next() override {
         return data[index++];
     }
+
+    std::size_t nextBatch(T* out, std::size_t count) override {
+        Chunk<T> chunk = nextChunk(count);
+        std::copy(chunk.begin(), chunk.end(), out);
+        return chunk.size();
+    }
+
+    // Zero-copy variant of nextBatch: a view of the next elements in place
+    Chunk<T> nextChunk(std::size_t count) {
+        count = std::min(count, data.size() - index);
+        Chunk<T> chunk{data.data() + index, count};
+        index += count;
+        return chunk;
+    }
+};
+
+// An iterator that can hand off part of its remaining elements, so one
+// traversal can be divided among threads. trySplit() moves roughly the
+// first half into a new iterator (or returns nullptr when it cannot split)
+// and this iterator keeps the rest.
+template <typename T>
+class SplittableIterator : public Iterator<T> {
+public:
+    static constexpr std::size_t unknownSize = SIZE_MAX;
+
+    virtual std::unique_ptr<SplittableIterator<T>> trySplit() = 0;
+    // Remaining element count, or unknownSize if it cannot be known cheaply
+    virtual std::size_t estimateSize() const = 0;
+};
+
+// Splits a contiguous range by halving its index interval
+template <typename T>
+class RangeSplittableIterator : public SplittableIterator<T> {
+private:
+    const T* first;
+    const T* last;
+
+public:
+    RangeSplittableIterator(const T* first, const T* last) : first(first), last(last) {}
+
+    bool hasNext() override {
+        return first != last;
+    }
+
+    T next() override {
+        return *first++;
+    }
+
+    std::size_t nextBatch(T* out, std::size_t count) override {
+        count = std::min<std::size_t>(count, last - first);
+        std::copy(first, first + count, out);
+        first += count;
+        return count;
+    }
+
+    std::unique_ptr<SplittableIterator<T>> trySplit() override {
+        std::size_t half = static_cast<std::size_t>(last - first) / 2;
+        if (half == 0) {
+            return nullptr;
+        }
+        auto prefix = std::make_unique<RangeSplittableIterator<T>>(first, first + half);
+        first += half;
+        return prefix;
+    }
+
+    std::size_t estimateSize() const override {
+        return static_cast<std::size_t>(last - first);
+    }
+};
+
+// Makes any sequential iterator splittable: each split drains the next batch
+// into an owned buffer, growing the batch so deep recursion is not needed
+template <typename T>
+class BufferingSplittableIterator : public SplittableIterator<T> {
+private:
+    // A drained batch: owns its elements and splits them as a range. Moving
+    // the vector into the member keeps its buffer, so the range stays valid.
+    class Batch : public RangeSplittableIterator<T> {
+    private:
+        std::vector<T> elements;
+
+    public:
+        explicit Batch(std::vector<T> elements)
+            : RangeSplittableIterator<T>(elements.data(), elements.data() + elements.size()),
+              elements(std::move(elements)) {}
+    };
+
+    static constexpr std::size_t maxBatch = std::size_t{1} << 24;
+
+    std::unique_ptr<Iterator<T>> source;
+    std::size_t batch = 1024;
+
+public:
+    explicit BufferingSplittableIterator(std::unique_ptr<Iterator<T>> source) : source(std::move(source)) {}
+
+    bool hasNext() override {
+        return source->hasNext();
+    }
+
+    T next() override {
+        return source->next();
+    }
+
+    std::size_t nextBatch(T* out, std::size_t count) override {
+        return source->nextBatch(out, count);
+    }
+
+    std::unique_ptr<SplittableIterator<T>> trySplit() override {
+        std::vector<T> elements;
+        if constexpr (std::is_default_constructible_v<T>) {
+            elements.resize(batch);
+            elements.resize(source->nextBatch(elements.data(), elements.size()));
+        } else {
+            while (elements.size() < batch && source->hasNext()) {
+                elements.push_back(source->next());
+            }
+        }
+        if (elements.empty()) {
+            return nullptr;
+        }
+        batch = std::min(batch * 2, maxBatch);
+        return std::make_unique<Batch>(std::move(elements));
+    }
+
+    std::size_t estimateSize() const override {
+        return SplittableIterator<T>::unknownSize;
+    }
 };
 
 template <typename T>
 class Aggregate {
 public:
     virtual Iterator<T>* createIterator() = 0;
+
+    // By default a sequential iterator is split by buffering batches of it;
+    // aggregates with random access can do better
+    virtual std::unique_ptr<SplittableIterator<T>> createSplittableIterator() {
+        return std::make_unique<BufferingSplittableIterator<T>>(std::unique_ptr<Iterator<T>>(createIterator()));
+    }
+
     virtual ~Aggregate() {}
 };
 
@@ -44,13 +232,524 @@ public:
         return new ConcreteIterator<T>(data);
     }
 
+    std::unique_ptr<SplittableIterator<T>> createSplittableIterator() override {
+        return std::make_unique<RangeSplittableIterator<T>>(data.data(), data.data() + data.size());
+    }
+
+    void add(T value) {
+        data.push_back(value);
+    }
+
+    // Standard range access, so plain loops compile to contiguous scans
+    typename std::vector<T>::iterator begin() { return data.begin(); }
+    typename std::vector<T>::iterator end() { return data.end(); }
+    typename std::vector<T>::const_iterator begin() const { return data.begin(); }
+    typename std::vector<T>::const_iterator end() const { return data.end(); }
+    std::size_t size() const { return data.size(); }
+    const T* elements() const { return data.data(); }
+};
+
+// A non-contiguous aggregate; it relies on the default buffering splitter
+template <typename T>
+class ListAggregate : public Aggregate<T> {
+private:
+    class ListIterator : public Iterator<T> {
+    private:
+        typename std::list<T>::const_iterator current;
+        typename std::list<T>::const_iterator last;
+    public:
+        explicit ListIterator(const std::list<T>& data) : current(data.begin()), last(data.end()) {}
+
+        bool hasNext() override {
+            return current != last;
+        }
+
+        T next() override {
+            return *current++;
+        }
+    };
+
+    std::list<T> data;
+public:
+    Iterator<T>* createIterator() override {
+        return new ListIterator(data);
+    }
+
     void add(T value) {
         data.push_back(value);
     }
 };
 
+// An aggregate stored in a file and mapped into memory, so it may be larger
+// than RAM and needs no loading up front. Elements are stored raw, hence T
+// must be trivially copyable. add() appends into spare mapped capacity,
+// growing the file and the mapping geometrically.
+template <typename T>
+class MappedAggregate : public Aggregate<T> {
+    static_assert(std::is_trivially_copyable<T>::value, "MappedAggregate stores raw bytes");
+
+public:
+    enum class Mode { ReadOnly, ReadWrite };
+
+private:
+    int fd;
+    Mode mode;
+    T* base = nullptr;
+    std::size_t count = 0;
+    std::size_t capacity = 0;
+
+    void grow() {
+        std::size_t wanted = std::max<std::size_t>(capacity * 2, (1 << 20) / sizeof(T) + 1);
+        if (::ftruncate(fd, static_cast<off_t>(wanted * sizeof(T))) != 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot grow mapped aggregate");
+        }
+        void* address = base
+            ? ::mremap(base, capacity * sizeof(T), wanted * sizeof(T), MREMAP_MAYMOVE)
+            : ::mmap(nullptr, wanted * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "cannot map aggregate");
+        }
+        base = static_cast<T*>(address);
+        capacity = wanted;
+    }
+
+public:
+    // Opens `path` (creating it in ReadWrite mode); its contents become the
+    // initial elements. A file that does not hold a whole number of
+    // elements is rejected rather than reinterpreted.
+    explicit MappedAggregate(const std::string& path, Mode mode = Mode::ReadWrite)
+        : fd(mode == Mode::ReadOnly ? ::open(path.c_str(), O_RDONLY)
+                                    : ::open(path.c_str(), O_RDWR | O_CREAT, 0644)),
+          mode(mode) {
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "cannot open " + path);
+        }
+        std::size_t bytes = static_cast<std::size_t>(info.st_size);
+        if (bytes % sizeof(T) != 0) {
+            ::close(fd);
+            throw std::runtime_error(path + " does not hold a whole number of elements");
+        }
+        count = capacity = bytes / sizeof(T);
+        if (capacity > 0) {
+            int protection = mode == Mode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+            void* address = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+            if (address == MAP_FAILED) {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "cannot map " + path);
+            }
+            base = static_cast<T*>(address);
+        }
+    }
+
+    // Trims the spare capacity grow() added, so the file holds exactly the
+    // elements
+    ~MappedAggregate() override {
+        if (base) {
+            ::munmap(base, capacity * sizeof(T));
+        }
+        if (capacity != count && ::ftruncate(fd, static_cast<off_t>(count * sizeof(T))) != 0) {
+            std::perror("MappedAggregate");
+        }
+        ::close(fd);
+    }
+
+    MappedAggregate(const MappedAggregate&) = delete;
+    MappedAggregate& operator=(const MappedAggregate&) = delete;
+
+    Iterator<T>* createIterator() override;
+
+    void add(T value) {
+        if (mode == Mode::ReadOnly) {
+            throw std::logic_error("cannot add to a read-only MappedAggregate");
+        }
+        if (count == capacity) {
+            grow();
+        }
+        base[count++] = value;
+    }
+
+    std::size_t size() const { return count; }
+    // May move when add() grows the mapping
+    const T* elements() const { return base; }
+};
+
+// Walks a MappedAggregate front to back. The kernel is told to read the
+// next window ahead of the cursor and to drop the window behind it, so a
+// scan of a file larger than RAM streams through with bounded memory.
+template <typename T>
+class MappedIterator : public Iterator<T> {
+private:
+    static constexpr std::size_t window = (8 << 20) / sizeof(T);
+
+    const MappedAggregate<T>& aggregate;
+    std::size_t index = 0;
+    std::size_t nextWindow = 0;   // index at which the next hint is due
+
+    void advise(int advice, std::size_t from, std::size_t to) const {
+        std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        auto begin = reinterpret_cast<std::uintptr_t>(aggregate.elements() + from) / page * page;
+        auto end = reinterpret_cast<std::uintptr_t>(aggregate.elements() + to);
+        if (end > begin) {
+            ::madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+        }
+    }
+
+    void prefetch() {
+        if (index < nextWindow) {
+            return;
+        }
+        std::size_t size = aggregate.size();
+        advise(MADV_WILLNEED, index, std::min(index + 2 * window, size));
+        if (index >= 2 * window) {
+            advise(MADV_DONTNEED, index - 2 * window, index - window);
+        }
+        nextWindow = index + window;
+    }
+
+public:
+    explicit MappedIterator(const MappedAggregate<T>& aggregate) : aggregate(aggregate) {}
+
+    bool hasNext() override {
+        return index < aggregate.size();
+    }
+
+    T next() override {
+        prefetch();
+        return aggregate.elements()[index++];
+    }
+
+    std::size_t nextBatch(T* out, std::size_t count) override {
+        prefetch();
+        count = std::min({count, aggregate.size() - index, nextWindow - index});
+        std::copy(aggregate.elements() + index, aggregate.elements() + index + count, out);
+        index += count;
+        return count;
+    }
+};
+
+template <typename T>
+Iterator<T>* MappedAggregate<T>::createIterator() {
+    return new MappedIterator<T>(*this);
+}
+
+// Lazy pipelines. Each adaptor is an Iterator that pulls from the stage
+// before it, which it holds by value, so a chain such as
+//     from(numbers) | filter(isEven) | map(square) | take(10)
+// is a single object: nothing is materialized between stages and the calls
+// between stages are resolved at compile time. Driving it with nextBatch()
+// processes a block of elements per stage in tight loops the compiler can
+// vectorize.
+
+template <typename Source, typename Predicate>
+class FilterIterator : public Iterator<typename Source::value_type> {
+private:
+    using T = typename Source::value_type;
+
+    Source source;
+    Predicate predicate;
+    std::optional<T> pending;   // element found by hasNext() but not yet returned
+
+public:
+    FilterIterator(Source source, Predicate predicate)
+        : source(std::move(source)), predicate(std::move(predicate)) {}
+
+    bool hasNext() override {
+        while (!pending && source.hasNext()) {
+            T value = source.next();
+            if (predicate(value)) {
+                pending = std::move(value);
+            }
+        }
+        return pending.has_value();
+    }
+
+    T next() override {
+        hasNext();
+        T value = std::move(*pending);
+        pending.reset();
+        return value;
+    }
+
+    // Fills `out` from the source, then compacts the survivors in place
+    // without branching on the predicate
+    std::size_t nextBatch(T* out, std::size_t count) override {
+        if (pending) {
+            out[0] = next();
+            return 1;
+        }
+        std::size_t kept = 0;
+        while (kept == 0) {
+            std::size_t read = source.nextBatch(out, count);
+            if (read == 0) {
+                break;
+            }
+            for (std::size_t i = 0; i < read; ++i) {
+                bool keep = predicate(out[i]);
+                out[kept] = out[i];
+                kept += keep;
+            }
+        }
+        return kept;
+    }
+};
+
+template <typename Source, typename Function>
+class MapIterator : public Iterator<std::invoke_result_t<Function&, typename Source::value_type>> {
+private:
+    using In = typename Source::value_type;
+    using Out = std::invoke_result_t<Function&, In>;
+
+    Source source;
+    Function function;
+    std::vector<In> input;      // reused scratch space for nextBatch()
+
+public:
+    MapIterator(Source source, Function function)
+        : source(std::move(source)), function(std::move(function)) {}
+
+    bool hasNext() override {
+        return source.hasNext();
+    }
+
+    Out next() override {
+        return function(source.next());
+    }
+
+    std::size_t nextBatch(Out* out, std::size_t count) override {
+        if constexpr (std::is_default_constructible_v<In>) {
+            input.resize(batchCapacity<In>());
+            std::size_t read = source.nextBatch(input.data(), std::min(count, input.size()));
+            for (std::size_t i = 0; i < read; ++i) {
+                out[i] = function(input[i]);
+            }
+            return read;
+        } else {
+            return Iterator<Out>::nextBatch(out, count);
+        }
+    }
+};
+
+template <typename Source>
+class TakeIterator : public Iterator<typename Source::value_type> {
+private:
+    using T = typename Source::value_type;
+
+    Source source;
+    std::size_t remaining;
+
+public:
+    TakeIterator(Source source, std::size_t limit) : source(std::move(source)), remaining(limit) {}
+
+    bool hasNext() override {
+        return remaining > 0 && source.hasNext();
+    }
+
+    T next() override {
+        --remaining;
+        return source.next();
+    }
+
+    std::size_t nextBatch(T* out, std::size_t count) override {
+        std::size_t read = source.nextBatch(out, std::min(count, remaining));
+        remaining -= read;
+        return read;
+    }
+};
+
+// Pipeline stage descriptions, bound to a source with operator|
+template <typename Predicate>
+struct FilterStage {
+    Predicate predicate;
+};
+
+template <typename Function>
+struct MapStage {
+    Function function;
+};
+
+struct TakeStage {
+    std::size_t limit;
+};
+
+template <typename Predicate>
+FilterStage<Predicate> filter(Predicate predicate) {
+    return {std::move(predicate)};
+}
+
+template <typename Function>
+MapStage<Function> map(Function function) {
+    return {std::move(function)};
+}
+
+inline TakeStage take(std::size_t limit) {
+    return {limit};
+}
+
+template <typename T>
+RangeSplittableIterator<T> from(const ConcreteAggregate<T>& aggregate) {
+    return RangeSplittableIterator<T>(aggregate.elements(), aggregate.elements() + aggregate.size());
+}
+
+template <typename Source, typename Predicate>
+FilterIterator<Source, Predicate> operator|(Source source, FilterStage<Predicate> stage) {
+    return {std::move(source), std::move(stage.predicate)};
+}
+
+template <typename Source, typename Function>
+MapIterator<Source, Function> operator|(Source source, MapStage<Function> stage) {
+    return {std::move(source), std::move(stage.function)};
+}
+
+template <typename Source>
+TakeIterator<Source> operator|(Source source, TakeStage stage) {
+    return {std::move(source), stage.limit};
+}
+
+// Runs a pipeline to the end in batches, calling `action` per element
+template <typename Pipeline, typename Action>
+void forEach(Pipeline& pipeline, Action action) {
+    using T = typename Pipeline::value_type;
+    if constexpr (std::is_default_constructible_v<T>) {
+        std::vector<T> buffer(batchCapacity<T>());
+        for (std::size_t count; (count = pipeline.nextBatch(buffer.data(), buffer.size())) != 0;) {
+            for (std::size_t i = 0; i < count; ++i) {
+                action(buffer[i]);
+            }
+        }
+    } else {
+        while (pipeline.hasNext()) {
+            action(pipeline.next());
+        }
+    }
+}
+
+template <typename Pipeline>
+std::vector<typename Pipeline::value_type> collect(Pipeline& pipeline) {
+    std::vector<typename Pipeline::value_type> result;
+    forEach(pipeline, [&result](const typename Pipeline::value_type& value) { result.push_back(value); });
+    return result;
+}
+
+// Reduces what is left of `iterator`: while it is big enough it is split
+// and the halves are reduced in parallel, the rest is folded in batches.
+// `accumulate` folds one element into a partial result and `combine` merges
+// two partial results; both must be associative, order is preserved.
+template <typename R, typename T, typename Accumulate, typename Combine>
+R reduceSplit(ForkJoinPool& pool, SplittableIterator<T>& iterator, const R& identity,
+              const Accumulate& accumulate, const Combine& combine, std::size_t grain) {
+    if (iterator.estimateSize() > grain) {
+        if (std::unique_ptr<SplittableIterator<T>> prefix = iterator.trySplit()) {
+            R left = identity;
+            R right = identity;
+            pool.invoke(
+                [&] { left = reduceSplit(pool, *prefix, identity, accumulate, combine, grain); },
+                [&] { right = reduceSplit(pool, iterator, identity, accumulate, combine, grain); });
+            return combine(std::move(left), std::move(right));
+        }
+    }
+    R result = identity;
+    if constexpr (std::is_default_constructible_v<T>) {
+        std::vector<T> buffer(batchCapacity<T>());
+        for (std::size_t count; (count = iterator.nextBatch(buffer.data(), buffer.size())) != 0;) {
+            for (std::size_t i = 0; i < count; ++i) {
+                result = accumulate(std::move(result), buffer[i]);
+            }
+        }
+    } else {
+        while (iterator.hasNext()) {
+            result = accumulate(std::move(result), iterator.next());
+        }
+    }
+    return result;
+}
+
+template <typename R, typename T, typename Accumulate, typename Combine>
+R parallel_reduce(ForkJoinPool& pool, Aggregate<T>& aggregate, R identity,
+                  Accumulate accumulate, Combine combine, std::size_t grain = 16384) {
+    std::unique_ptr<SplittableIterator<T>> iterator = aggregate.createSplittableIterator();
+    R result = identity;
+    pool.run([&] { result = reduceSplit(pool, *iterator, identity, accumulate, combine, grain); });
+    return result;
+}
+
+// Calls `action` on every element, from several threads at once
+template <typename T, typename Action>
+void parallel_for_each(ForkJoinPool& pool, Aggregate<T>& aggregate, Action action,
+                       std::size_t grain = 16384) {
+    struct Nothing {};
+    parallel_reduce(pool, aggregate, Nothing{},
+                    [&action](Nothing, const T& value) { action(value); return Nothing{}; },
+                    [](Nothing, Nothing) { return Nothing{}; }, grain);
+}
+
+// Wall time of one run of `job`, in nanoseconds per element
+template <typename F>
+double nanosecondsPerElement(std::size_t elements, F&& job) {
+    auto start = std::chrono::steady_clock::now();
+    job();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / elements;
+}
+
+// An element too large to pass around by value cheaply
+struct Record {
+    long id = 0;
+    double values[31] = {};
+};
+
+// Sums `key` over the aggregate four ways: a virtual next() per element,
+// nextBatch() into a buffer, zero-copy nextChunk() views and a plain range
+// loop over the aggregate
+template <typename T, typename Key>
+void timeTraversals(const char* label, ConcreteAggregate<T>& aggregate, Key key) {
+    std::size_t size = aggregate.size();
+    long totals[4] = {};
+    double perElement = nanosecondsPerElement(size, [&] {
+        std::unique_ptr<Iterator<T>> cursor(aggregate.createIterator());
+        while (cursor->hasNext()) {
+            totals[0] += key(cursor->next());
+        }
+    });
+    double batched = nanosecondsPerElement(size, [&] {
+        std::unique_ptr<Iterator<T>> cursor(aggregate.createIterator());
+        std::vector<T> buffer(batchCapacity<T>());
+        for (std::size_t count; (count = cursor->nextBatch(buffer.data(), buffer.size())) != 0;) {
+            for (std::size_t i = 0; i < count; ++i) {
+                totals[1] += key(buffer[i]);
+            }
+        }
+    });
+    double chunked = nanosecondsPerElement(size, [&] {
+        // ConcreteAggregate always hands out a ConcreteIterator
+        std::unique_ptr<ConcreteIterator<T>> cursor(static_cast<ConcreteIterator<T>*>(aggregate.createIterator()));
+        for (Chunk<T> chunk; (chunk = cursor->nextChunk(4096)).size() != 0;) {
+            for (const T& value : chunk) {
+                totals[2] += key(value);
+            }
+        }
+    });
+    double ranged = nanosecondsPerElement(size, [&] {
+        for (const T& value : aggregate) {
+            totals[3] += key(value);
+        }
+    });
+    bool agree = totals[0] == totals[1] && totals[1] == totals[2] && totals[2] == totals[3];
+    std::cout << label << " (" << sizeof(T) << " bytes), ns/element: next() " << perElement
+              << ", nextBatch " << batched << ", nextChunk " << chunked << ", range " << ranged
+              << (agree ? "" : " (totals differ!)") << std::endl;
+}
+
 // Klient
-int main() {
+// Usage: iterator [threads] [elements] [megabytes] - the first two size the
+// parallel reduce timings, the last the mapped file scanned at the end
+int main(int argc, char* argv[]) {
     ConcreteAggregate<int> collection({1, 2, 3, 4, 5});
     Iterator<int>* iterator = collection.createIterator();
 
@@ -59,5 +758,197 @@ int main() {
     }
 
     delete iterator;
+
+    // Batched iteration: one virtual call per batch of elements
+    std::unique_ptr<Iterator<int>> batched(collection.createIterator());
+    int buffer[2];
+    int sum = 0;
+    for (std::size_t count; (count = batched->nextBatch(buffer, 2)) != 0;) {
+        for (std::size_t i = 0; i < count; ++i) {
+            sum += buffer[i];
+        }
+    }
+    std::cout << "\nSum over batches: " << sum;
+
+    // Range-based iteration straight over the aggregate
+    int product = 1;
+    for (int value : collection) {
+        product *= value;
+    }
+    std::cout << "\nProduct over range: " << product << std::endl;
+
+    // The cost of reaching each element, small and large
+    {
+        ConcreteAggregate<int> ints({});
+        for (int i = 0; i < 10000000; ++i) {
+            ints.add(i % 1000);
+        }
+        timeTraversals("int", ints, [](int value) { return long{value}; });
+
+        ConcreteAggregate<Record> records({});
+        for (long i = 0; i < 200000; ++i) {
+            Record record;
+            record.id = i;
+            records.add(record);
+        }
+        timeTraversals("Record", records, [](const Record& record) { return record.id; });
+    }
+
+    // Parallel traversal of a contiguous and a linked aggregate
+    ConcreteAggregate<long> numbers({});
+    ListAggregate<long> linked;
+    for (long i = 1; i <= 100000; ++i) {
+        numbers.add(i);
+        linked.add(i);
+    }
+    ForkJoinPool pool;
+    auto plus = [](long a, long b) { return a + b; };
+    std::cout << "Parallel sum: " << parallel_reduce(pool, numbers, 0L, plus, plus)
+              << ", over a list: " << parallel_reduce(pool, linked, 0L, plus, plus) << std::endl;
+    std::atomic<long> evens{0};
+    parallel_for_each(pool, numbers, [&evens](long value) {
+        if (value % 2 == 0) {
+            evens.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    std::cout << "Even numbers: " << evens << std::endl;
+
+    // Parallel reduce timings on one thread and on the configured pool
+    {
+        std::size_t threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+        std::size_t elements = argc > 2 ? std::stoul(argv[2]) : 4000000;
+        ConcreteAggregate<long> contiguous({});
+        ListAggregate<long> list;
+        for (std::size_t i = 0; i < elements; ++i) {
+            contiguous.add(static_cast<long>(i));
+            list.add(static_cast<long>(i));
+        }
+        ForkJoinPool single(1);
+        ForkJoinPool configured(threads);
+        auto time = [&](ForkJoinPool& on, Aggregate<long>& aggregate) {
+            long total = 0;
+            double nanoseconds = nanosecondsPerElement(elements, [&] {
+                total = parallel_reduce(on, aggregate, 0L, plus, plus);
+            });
+            return std::make_pair(nanoseconds, total);
+        };
+        for (auto [label, aggregate] : {std::pair<const char*, Aggregate<long>*>{"contiguous", &contiguous},
+                                        std::pair<const char*, Aggregate<long>*>{"list", &list}}) {
+            auto [serial, serialTotal] = time(single, *aggregate);
+            auto [parallel, parallelTotal] = time(configured, *aggregate);
+            std::cout << "parallel_reduce over " << elements << " " << label << " elements: 1 thread "
+                      << serial << " ns/element, " << configured.size() << " threads " << parallel
+                      << " ns/element" << (serialTotal == parallelTotal ? "" : " (totals differ!)") << std::endl;
+        }
+    }
+
+    // A fused lazy pipeline: no intermediate containers between stages
+    auto squares = from(numbers)
+                 | filter([](long value) { return value % 2 == 0; })
+                 | map([](long value) { return value * value; })
+                 | take(5);
+    std::cout << "First even squares:";
+    for (long value : collect(squares)) {
+        std::cout << " " << value;
+    }
+    std::cout << std::endl;
+
+    // The same filter | map chain fused, against materializing a vector per
+    // step; with take() the fused chain also stops reading early
+    {
+        const std::size_t elements = 10000000;
+        ConcreteAggregate<long> source({});
+        for (std::size_t i = 0; i < elements; ++i) {
+            source.add(static_cast<long>(i % 100000));
+        }
+        auto isEven = [](long value) { return value % 2 == 0; };
+        auto square = [](long value) { return value * value; };
+        for (std::size_t limit : {elements, elements / 100}) {
+            long fusedTotal = 0;
+            double fused = nanosecondsPerElement(elements, [&] {
+                auto pipeline = from(source) | filter(isEven) | map(square) | take(limit);
+                forEach(pipeline, [&fusedTotal](long value) { fusedTotal += value; });
+            });
+            long materializedTotal = 0;
+            double materialized = nanosecondsPerElement(elements, [&] {
+                std::vector<long> evens;
+                for (long value : source) {
+                    if (isEven(value)) {
+                        evens.push_back(value);
+                    }
+                }
+                std::vector<long> squares;
+                for (long value : evens) {
+                    squares.push_back(square(value));
+                }
+                squares.resize(std::min(squares.size(), limit));
+                for (long value : squares) {
+                    materializedTotal += value;
+                }
+            });
+            std::cout << "filter | map | take(" << limit << ") over " << elements << " elements: fused " << fused
+                      << " ns/element, materialized " << materialized << " ns/element"
+                      << (fusedTotal == materializedTotal ? "" : " (totals differ!)") << std::endl;
+        }
+    }
+
+    // A file-backed aggregate read through the same Iterator interface
+    {
+        MappedAggregate<long> stored("iterator.data");
+        for (long i = 1; i <= 100000; ++i) {
+            stored.add(i);
+        }
+    }
+    {
+        MappedAggregate<long> stored("iterator.data", MappedAggregate<long>::Mode::ReadOnly);
+        std::unique_ptr<Iterator<long>> cursor(stored.createIterator());
+        long total = 0;
+        while (cursor->hasNext()) {
+            total += cursor->next();
+        }
+        std::cout << "Sum from mapped file: " << total << std::endl;
+    }
+    std::remove("iterator.data");
+
+    // Scan throughput of a mapped file. Unless it is larger than physical
+    // memory the scans are served from the page cache the writes filled.
+    {
+        std::size_t megabytes = argc > 3 ? std::stoul(argv[3]) : 256;
+        std::size_t count = megabytes * (std::size_t{1} << 20) / sizeof(long);
+        double appended;
+        {
+            MappedAggregate<long> stored("iterator.data");
+            appended = nanosecondsPerElement(count, [&] {
+                for (std::size_t i = 0; i < count; ++i) {
+                    stored.add(static_cast<long>(i));
+                }
+            });
+        }
+        MappedAggregate<long> stored("iterator.data", MappedAggregate<long>::Mode::ReadOnly);
+        long batchedTotal = 0;
+        double batched = nanosecondsPerElement(count, [&] {
+            std::unique_ptr<Iterator<long>> cursor(stored.createIterator());
+            std::vector<long> buffer(batchCapacity<long>());
+            for (std::size_t read; (read = cursor->nextBatch(buffer.data(), buffer.size())) != 0;) {
+                for (std::size_t i = 0; i < read; ++i) {
+                    batchedTotal += buffer[i];
+                }
+            }
+        });
+        long elementTotal = 0;
+        double perElement = nanosecondsPerElement(count, [&] {
+            std::unique_ptr<Iterator<long>> cursor(stored.createIterator());
+            while (cursor->hasNext()) {
+                elementTotal += cursor->next();
+            }
+        });
+        // bytes per nanosecond times 1000 is MB/s
+        auto megabytesPerSecond = [](double nanoseconds) { return sizeof(long) / nanoseconds * 1e3; };
+        std::cout << "MappedAggregate, " << megabytes << " MiB: add " << megabytesPerSecond(appended)
+                  << " MB/s, scan by nextBatch " << megabytesPerSecond(batched) << " MB/s, by next() "
+                  << megabytesPerSecond(perElement) << " MB/s"
+                  << (batchedTotal == elementTotal ? "" : " (totals differ!)") << std::endl;
+    }
+    std::remove("iterator.data");
     return 0;
 }
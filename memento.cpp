@@ -1,28 +1,395 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 #include <vector>
 
-// Memento - stores the state of the Originator
+#include <sys/mman.h>
+
+// AddBuffer - append-only storage for every piece of text ever typed. Text
+// is copied into fixed-size blocks that never move or change once written,
+// so pieces may keep pointing into them for as long as they live.
+class AddBuffer {
+public:
+    struct Block {
+        std::unique_ptr<char[]> bytes;
+        std::size_t capacity;
+    };
+
+    // A slice of one block; the shared block keeps the bytes alive
+    struct Piece {
+        std::shared_ptr<const Block> block;
+        std::size_t offset;
+        std::size_t length;
+
+        std::string_view view() const {
+            return std::string_view(block->bytes.get() + offset, length);
+        }
+    };
+
+private:
+    static constexpr std::size_t blockSize = 64 * 1024;
+
+    std::shared_ptr<Block> current;
+    std::size_t used = 0;
+
+    static std::shared_ptr<Block> makeBlock(std::size_t capacity) {
+        return std::make_shared<Block>(Block{std::make_unique<char[]>(capacity), capacity});
+    }
+
+public:
+    Piece append(std::string_view text) {
+        if (text.size() > blockSize) {
+            // Large pastes get a block of their own instead of wasting a tail
+            auto block = makeBlock(text.size());
+            std::copy(text.begin(), text.end(), block->bytes.get());
+            return Piece{block, 0, text.size()};
+        }
+        if (!current || used + text.size() > current->capacity) {
+            current = makeBlock(blockSize);
+            used = 0;
+        }
+        std::copy(text.begin(), text.end(), current->bytes.get() + used);
+        Piece piece{current, used, text.size()};
+        used += text.size();
+        return piece;
+    }
+
+};
+
+// PieceTree - immutable, balanced tree of pieces. Every edit returns a new
+// tree that shares all untouched nodes with the old one, so keeping many
+// versions alive costs only the changed paths, not a copy of the document.
+class PieceTree {
+private:
+    using Piece = AddBuffer::Piece;
+
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        NodePtr left;
+        NodePtr right;
+        Piece piece;        // only used by leaves
+        std::size_t length;
+        int height;
+    };
+
+    NodePtr root;
+
+    explicit PieceTree(NodePtr root) : root(std::move(root)) {}
+
+    static int height(const NodePtr &node) {
+        return node ? node->height : 0;
+    }
+
+    static std::size_t length(const NodePtr &node) {
+        return node ? node->length : 0;
+    }
+
+    static NodePtr leaf(Piece piece) {
+        std::size_t size = piece.length;
+        return std::make_shared<const Node>(Node{nullptr, nullptr, std::move(piece), size, 1});
+    }
+
+    static NodePtr concat(NodePtr left, NodePtr right) {
+        std::size_t size = left->length + right->length;
+        int h = std::max(left->height, right->height) + 1;
+        return std::make_shared<const Node>(Node{std::move(left), std::move(right), {}, size, h});
+    }
+
+    static NodePtr rotateLeft(const NodePtr &node) {
+        const NodePtr &r = node->right;
+        return concat(concat(node->left, r->left), r->right);
+    }
+
+    static NodePtr rotateRight(const NodePtr &node) {
+        const NodePtr &l = node->left;
+        return concat(l->left, concat(l->right, node->right));
+    }
+
+    // AVL rebalancing of a freshly built internal node
+    static NodePtr balance(const NodePtr &node) {
+        int diff = height(node->left) - height(node->right);
+        if (diff > 1) {
+            if (height(node->left->left) < height(node->left->right)) {
+                return rotateRight(concat(rotateLeft(node->left), node->right));
+            }
+            return rotateRight(node);
+        }
+        if (diff < -1) {
+            if (height(node->right->right) < height(node->right->left)) {
+                return rotateLeft(concat(node->left, rotateRight(node->right)));
+            }
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    // Joins two balanced trees; only nodes along one spine are rebuilt
+    static NodePtr join(const NodePtr &left, const NodePtr &right) {
+        if (!left) return right;
+        if (!right) return left;
+        if (left->height > right->height + 1) {
+            return balance(concat(left->left, join(left->right, right)));
+        }
+        if (right->height > left->height + 1) {
+            return balance(concat(join(left, right->left), right->right));
+        }
+        return concat(left, right);
+    }
+
+    // Splits into [0, pos) and [pos, length); a piece cut in two is just
+    // re-sliced, no text is copied
+    static std::pair<NodePtr, NodePtr> split(const NodePtr &node, std::size_t pos) {
+        if (!node) return {nullptr, nullptr};
+        if (pos == 0) return {nullptr, node};
+        if (pos >= node->length) return {node, nullptr};
+        if (!node->left) {
+            const Piece &p = node->piece;
+            return {leaf(Piece{p.block, p.offset, pos}),
+                    leaf(Piece{p.block, p.offset + pos, p.length - pos})};
+        }
+        std::size_t leftLength = node->left->length;
+        if (pos <= leftLength) {
+            auto parts = split(node->left, pos);
+            return {parts.first, join(parts.second, node->right)};
+        }
+        auto parts = split(node->right, pos - leftLength);
+        return {join(node->left, parts.first), parts.second};
+    }
+
+    // Rebuilds the right spine with the last piece grown by `extra` bytes
+    static NodePtr extendLastPiece(const NodePtr &node, std::size_t extra) {
+        if (!node->left) {
+            const Piece &p = node->piece;
+            return leaf(Piece{p.block, p.offset, p.length + extra});
+        }
+        return concat(node->left, extendLastPiece(node->right, extra));
+    }
+
+    static const Node &lastLeaf(const Node &node) {
+        return node.right ? lastLeaf(*node.right) : node;
+    }
+
+    // Length of the run of identical pieces at the start (or, with
+    // `fromEnd`, the end) of two trees. Subtrees both versions share are
+    // skipped whole, so the cost follows the edited region, not the document.
+    static std::size_t commonEdge(const NodePtr &a, const NodePtr &b, bool fromEnd) {
+        struct Cursor {
+            std::vector<const Node *> stack;    // back() is the next subtree
+            std::size_t skipped = 0;            // bytes already matched in a leaf on top
+
+            void expand(bool fromEnd) {
+                const Node *node = stack.back();
+                stack.pop_back();
+                stack.push_back(fromEnd ? node->left.get() : node->right.get());
+                stack.push_back(fromEnd ? node->right.get() : node->left.get());
+            }
+        };
+        Cursor x;
+        Cursor y;
+        if (a) x.stack.push_back(a.get());
+        if (b) y.stack.push_back(b.get());
+        std::size_t common = 0;
+        while (!x.stack.empty() && !y.stack.empty()) {
+            const Node *p = x.stack.back();
+            const Node *q = y.stack.back();
+            if (p == q && x.skipped == 0 && y.skipped == 0) {
+                common += p->length;
+                x.stack.pop_back();
+                y.stack.pop_back();
+            } else if (p->left || q->left) {
+                Cursor &larger = !q->left || (p->left && p->length >= q->length) ? x : y;
+                larger.expand(fromEnd);
+            } else {
+                // Two leaves: equal if they cover the same bytes of one block
+                std::size_t restP = p->length - x.skipped;
+                std::size_t restQ = q->length - y.skipped;
+                std::size_t startP = p->piece.offset + (fromEnd ? 0 : x.skipped);
+                std::size_t startQ = q->piece.offset + (fromEnd ? 0 : y.skipped);
+                bool same = p->piece.block == q->piece.block &&
+                            (fromEnd ? startP + restP == startQ + restQ : startP == startQ);
+                if (!same) {
+                    break;
+                }
+                std::size_t matched = std::min(restP, restQ);
+                common += matched;
+                for (Cursor *cursor : {&x, &y}) {
+                    cursor->skipped += matched;
+                    if (cursor->skipped == cursor->stack.back()->length) {
+                        cursor->stack.pop_back();
+                        cursor->skipped = 0;
+                    }
+                }
+            }
+        }
+        return common;
+    }
+
+public:
+    // Streams the document as borrowed chunks, one per piece, in order
+    class ChunkIterator {
+    private:
+        std::vector<const Node *> pending;
+        const Node *current = nullptr;
+
+        void descend(const Node *node) {
+            while (node->left) {
+                pending.push_back(node->right.get());
+                node = node->left.get();
+            }
+            current = node;
+        }
+
+    public:
+        ChunkIterator() = default;
+
+        explicit ChunkIterator(const Node *root) {
+            if (root) {
+                descend(root);
+            }
+        }
+
+        std::string_view operator*() const {
+            return current->piece.view();
+        }
+
+        ChunkIterator &operator++() {
+            if (pending.empty()) {
+                current = nullptr;
+            } else {
+                const Node *next = pending.back();
+                pending.pop_back();
+                descend(next);
+            }
+            return *this;
+        }
+
+        bool operator!=(const ChunkIterator &other) const {
+            return current != other.current;
+        }
+    };
+
+    PieceTree() = default;
+
+    PieceTree insert(std::size_t pos, AddBuffer &buffer, std::string_view text) const {
+        if (text.empty()) {
+            return *this;
+        }
+        pos = std::min(pos, size());
+        Piece piece = buffer.append(text);
+        if (pos == size() && root) {
+            const Piece &last = lastLeaf(*root).piece;
+            if (last.block == piece.block && last.offset + last.length == piece.offset) {
+                // Typing at the end keeps extending the same piece
+                return PieceTree(extendLastPiece(root, piece.length));
+            }
+        }
+        auto parts = split(root, pos);
+        return PieceTree(join(join(parts.first, leaf(std::move(piece))), parts.second));
+    }
+
+    PieceTree erase(std::size_t pos, std::size_t count) const {
+        auto head = split(root, pos);
+        auto tail = split(head.second, count);
+        return PieceTree(join(head.first, tail.second));
+    }
+
+    // The `count` bytes at `pos`, sharing this tree's pieces
+    PieceTree slice(std::size_t pos, std::size_t count) const {
+        return PieceTree(split(split(root, pos).second, count).first);
+    }
+
+    PieceTree append(const PieceTree &other) const {
+        return PieceTree(join(root, other.root));
+    }
+
+    // How many leading and trailing bytes `to` keeps from `from`; the rest of
+    // `to` is what changed. The two never overlap.
+    static std::pair<std::size_t, std::size_t> commonEnds(const PieceTree &from, const PieceTree &to) {
+        std::size_t limit = std::min(from.size(), to.size());
+        std::size_t prefix = std::min(commonEdge(from.root, to.root, false), limit);
+        std::size_t suffix = std::min(commonEdge(from.root, to.root, true), limit - prefix);
+        return {prefix, suffix};
+    }
+
+    std::size_t size() const {
+        return length(root);
+    }
+
+    ChunkIterator begin() const {
+        return ChunkIterator(root.get());
+    }
+
+    ChunkIterator end() const {
+        return ChunkIterator();
+    }
+
+    std::string toString() const {
+        std::string out;
+        out.reserve(size());
+        for (std::string_view chunk : *this) {
+            out += chunk;
+        }
+        return out;
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const PieceTree &text) {
+    for (std::string_view chunk : text) {
+        os << chunk;
+    }
+    return os;
+}
+
+// Memento - stores the state of the Originator. It only holds the root of
+// an immutable piece tree, so taking and keeping a snapshot is O(1).
 class Memento {
 private:
-    std::string state;
+    PieceTree state;
 
 public:
-    Memento(const std::string &state) : state(state) {}
+    explicit Memento(PieceTree state) : state(std::move(state)) {}
 
-    std::string getState() const {
+    const PieceTree &getTree() const {
         return state;
     }
+
+    std::string getState() const {
+        return state.toString();
+    }
 };
 
 // Originator - class whose state is saved
 class Editor {
 private:
-    std::string content;
+    AddBuffer buffer;
+    PieceTree content;
 
 public:
     void type(const std::string &words) {
-        content += words;
+        content = content.insert(content.size(), buffer, words);
+    }
+
+    void insert(std::size_t pos, const std::string &words) {
+        content = content.insert(pos, buffer, words);
+    }
+
+    void erase(std::size_t pos, std::size_t count) {
+        content = content.erase(pos, count);
     }
 
     Memento save() {
@@ -30,34 +397,300 @@ public:
     }
 
     void restore(const Memento &memento) {
-        content = memento.getState();
+        content = memento.getTree();
     }
 
-    std::string getContent() const {
+    // Returns a snapshot view; iterate it for chunks or call toString()
+    PieceTree getContent() const {
         return content;
     }
 };
 
-// Caretaker - manages saved states
+// HistoryFile - append-only file of spilled snapshots. Records are read back
+// through a read-only mapping, so restoring one only pages in the records it
+// actually touches.
+class HistoryFile {
+public:
+    // A keyframe stores the whole text; a delta keeps `prefix` bytes from the
+    // front and `suffix` bytes from the back of the previous record's text
+    struct RecordHeader {
+        std::uint64_t prefix;
+        std::uint64_t suffix;
+        std::uint64_t length;
+    };
+
+private:
+    std::FILE *file;
+    std::uint64_t size = 0;
+    const char *mapping = nullptr;
+    std::size_t mappedSize = 0;
+
+    void write(const void *data, std::size_t count) {
+        if (std::fwrite(data, 1, count, file) != count) {
+            throw std::system_error(errno, std::generic_category(), "history write failed");
+        }
+        size += count;
+    }
+
+    void remap() {
+        if (std::fflush(file) != 0) {
+            throw std::system_error(errno, std::generic_category(), "history write failed");
+        }
+        if (mapping) {
+            munmap(const_cast<char *>(mapping), mappedSize);
+        }
+        void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileno(file), 0);
+        if (address == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "history mmap failed");
+        }
+        mapping = static_cast<const char *>(address);
+        mappedSize = size;
+    }
+
+public:
+    HistoryFile() : file(std::tmpfile()) {
+        if (!file) {
+            throw std::system_error(errno, std::generic_category(), "cannot create history file");
+        }
+    }
+
+    ~HistoryFile() {
+        if (mapping) {
+            munmap(const_cast<char *>(mapping), mappedSize);
+        }
+        std::fclose(file);
+    }
+
+    HistoryFile(const HistoryFile &) = delete;
+    HistoryFile &operator=(const HistoryFile &) = delete;
+
+    // Writes the header and then `text` chunk by chunk, never flattening it
+    std::uint64_t append(const RecordHeader &header, const PieceTree &text) {
+        std::uint64_t offset = size;
+        write(&header, sizeof(header));
+        for (std::string_view chunk : text) {
+            write(chunk.data(), chunk.size());
+        }
+        return offset;
+    }
+
+    std::pair<RecordHeader, std::string_view> read(std::uint64_t offset) {
+        if (offset + sizeof(RecordHeader) > mappedSize) {
+            remap();
+        }
+        RecordHeader header;
+        std::memcpy(&header, mapping + offset, sizeof(header));
+        if (offset + sizeof(header) + header.length > mappedSize) {
+            remap();
+        }
+        return {header, std::string_view(mapping + offset + sizeof(header), header.length)};
+    }
+};
+
+// Caretaker - manages saved states within a memory budget. A memento is
+// charged for the text it changed relative to the one saved before it (plus
+// a fixed bookkeeping cost), which is what it keeps alive that its
+// neighbours do not. Once the newest mementos exceed `residentBytes`, older
+// ones are spilled to the history file as deltas against the previously
+// spilled state. Deltas come from comparing the piece trees, which share
+// every untouched subtree, so neither saving nor spilling flattens the
+// document. A full keyframe is written once `keyframeBytes` of deltas have
+// accumulated, which bounds how much a restore has to replay.
+//
+// Saving only records the memento (an O(1) immutable root) and returns; the
+// spilling runs on a background thread, so editing never waits for
+// snapshots to be written. If a spill fails (say the disk is full) spilling
+// stops, every later memento stays resident, and the error is reported by
+// the next flush() or saveState().
 class Caretaker {
 private:
-    std::vector<Memento> mementos;
+    static constexpr std::size_t entryCost = 128;
+
+    struct Entry {
+        std::optional<Memento> memento;
+        std::size_t cost = 0;           // budget charged while resident
+        std::uint64_t offset = 0;       // record in the history file once spilled
+        bool keyframe = false;
+    };
+
+    std::size_t residentBytes;
+    std::size_t keyframeBytes;
+
+    std::mutex mutex;               // guards entries and the spill counters
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<Entry> entries;
+    PieceTree lastSaved;
+    std::size_t residentCost = 0;   // total cost of entries from spillTarget on
+    std::size_t firstResident = 0;  // entries before this one live in the history file
+    std::size_t spillTarget = 0;
+    bool stopping = false;
+    bool spillFailed = false;
+    std::exception_ptr spillError;  // not yet reported to the caller
+
+    std::mutex historyMutex;
+    HistoryFile history;
+    PieceTree lastSpilled;          // worker only: newest spilled state
+    std::size_t sinceKeyframe = SIZE_MAX;   // worker only: delta bytes since the last keyframe
+    AddBuffer reloadBuffer;         // restoring thread only
+
+    std::thread worker;
+
+    // Returns the record's offset and whether it is a keyframe
+    std::pair<std::uint64_t, bool> persist(const Memento &memento) {
+        const PieceTree &tree = memento.getTree();
+        HistoryFile::RecordHeader header{0, 0, tree.size()};
+        PieceTree bytes = tree;
+        bool keyframe = sinceKeyframe >= keyframeBytes;
+        if (!keyframe) {
+            auto ends = PieceTree::commonEnds(lastSpilled, tree);
+            header = HistoryFile::RecordHeader{ends.first, ends.second, tree.size() - ends.first - ends.second};
+            bytes = tree.slice(ends.first, header.length);
+        }
+        std::uint64_t offset;
+        {
+            std::lock_guard<std::mutex> lock(historyMutex);
+            offset = history.append(header, bytes);
+        }
+        sinceKeyframe = keyframe ? 0 : sinceKeyframe + sizeof(header) + header.length;
+        lastSpilled = tree;
+        return {offset, keyframe};
+    }
+
+    void spillLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || (!spillFailed && firstResident < spillTarget); });
+            if (stopping) {
+                return;
+            }
+            std::size_t index = firstResident;
+            Memento memento = *entries[index].memento;
+            lock.unlock();
+            std::pair<std::uint64_t, bool> record;
+            std::exception_ptr error;
+            try {
+                record = persist(memento);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            if (error) {
+                spillFailed = true;
+                spillError = error;
+                idle.notify_all();
+                continue;
+            }
+            entries[index].offset = record.first;
+            entries[index].keyframe = record.second;
+            entries[index].memento.reset();
+            ++firstResident;
+            idle.notify_all();
+        }
+    }
+
+    // Rebuilds a state from its keyframe and the deltas after it. Each delta
+    // is applied as slices of the previous tree, so only the keyframe and the
+    // changed bytes are copied.
+    Memento reload(const std::vector<std::uint64_t> &offsets) {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        PieceTree text = PieceTree().insert(0, reloadBuffer, history.read(offsets.front()).second);
+        for (std::size_t i = 1; i < offsets.size(); ++i) {
+            auto record = history.read(offsets[i]);
+            const HistoryFile::RecordHeader &header = record.first;
+            text = text.slice(0, header.prefix)
+                       .append(PieceTree().insert(0, reloadBuffer, record.second))
+                       .append(text.slice(text.size() - header.suffix, header.suffix));
+        }
+        return Memento(text);
+    }
 
 public:
+    explicit Caretaker(std::size_t residentBytes = 64 << 20, std::size_t keyframeBytes = 4 << 20)
+        : residentBytes(residentBytes), keyframeBytes(keyframeBytes),
+          worker(&Caretaker::spillLoop, this) {}
+
+    ~Caretaker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    Caretaker(const Caretaker &) = delete;
+    Caretaker &operator=(const Caretaker &) = delete;
+
+    // Records the state even when it rethrows an earlier spill failure. The
+    // newest memento always stays resident.
     void saveState(Editor &editor) {
-        mementos.push_back(editor.save());
+        Memento memento = editor.save();
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const PieceTree &tree = memento.getTree();
+            auto ends = PieceTree::commonEnds(lastSaved, tree);
+            std::size_t cost = entryCost + tree.size() - ends.first - ends.second;
+            lastSaved = tree;
+            entries.push_back(Entry{std::move(memento), cost});
+            residentCost += cost;
+            while (residentCost > residentBytes && spillTarget + 1 < entries.size()) {
+                residentCost -= entries[spillTarget++].cost;
+            }
+            std::swap(error, spillError);
+        }
+        wake.notify_one();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Blocks until every pending spill has reached the history file, or
+    // rethrows the error that stopped spilling
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return spillFailed || firstResident >= spillTarget; });
+        std::exception_ptr error;
+        std::swap(error, spillError);
+        lock.unlock();
+        if (error) {
+            std::rethrow_exception(error);
+        }
     }
 
-    void restoreState(Editor &editor, int index) {
-        if (index < mementos.size()) {
-            editor.restore(mementos[index]);
+    void restoreState(Editor &editor, std::size_t index) {
+        std::vector<std::uint64_t> offsets;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (index >= entries.size()) {
+                return;
+            }
+            if (entries[index].memento) {
+                editor.restore(*entries[index].memento);
+                return;
+            }
+            std::size_t first = index;
+            while (!entries[first].keyframe) {
+                --first;
+            }
+            for (std::size_t i = first; i <= index; ++i) {
+                offsets.push_back(entries[i].offset);
+            }
         }
+        editor.restore(reload(offsets));
+    }
+
+    std::size_t spilledCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return firstResident;
     }
 };
 
 int main() {
     Editor editor;
-    Caretaker caretaker;
+    // A tiny budget, so even this short history goes through the history file
+    Caretaker caretaker(256, 64);
 
     editor.type("First line of text.");
     caretaker.saveState(editor);
@@ -66,10 +699,89 @@ int main() {
     caretaker.saveState(editor);
 
     editor.type(" Third line of text.");
+    caretaker.flush();
+    std::cout << "Spilled mementos: " << caretaker.spilledCount() << std::endl;
 
-    // Restore to the first saved state
+    // Restore to the first saved state, rebuilt from the history file
     caretaker.restoreState(editor, 0);
     std::cout << "Current state of editor: " << editor.getContent() << std::endl;
 
+    // Edits in the middle only re-slice pieces, the typed text is never moved
+    editor.insert(0, "Title. ");
+    editor.erase(7, 6);
+    std::cout << "After editing: " << editor.getContent() << std::endl;
+
+    // Typing, inserting and erasing stay cheap on a large document; the
+    // baseline is the same insert into one contiguous std::string
+    {
+        const std::size_t documentSize = 256 << 20;
+        const std::size_t edits = 100000;
+        Editor large;
+        std::string line(4096, 'y');
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t typed = 0; typed < documentSize; typed += line.size()) {
+            large.type(line);
+        }
+        auto typed = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < edits; ++i) {
+            large.insert(i * 2654435761u % documentSize, "insert");
+        }
+        auto inserted = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < edits; ++i) {
+            large.erase(i * 40503u % documentSize, 6);
+        }
+        auto erased = std::chrono::steady_clock::now();
+        std::size_t streamed = 0;
+        for (std::string_view chunk : large.getContent()) {
+            streamed += chunk.size();
+        }
+        auto scanned = std::chrono::steady_clock::now();
+        std::string flat(documentSize, 'y');
+        auto flatStart = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < 10; ++i) {
+            flat.insert(i * 2654435761u % documentSize, "insert");
+        }
+        auto flatDone = std::chrono::steady_clock::now();
+        using Nanoseconds = std::chrono::duration<double, std::nano>;
+        std::cout << (documentSize >> 20) << " MiB document: append " << Nanoseconds(typed - start).count() / (documentSize / line.size())
+                  << " ns per 4 KiB, insert " << Nanoseconds(inserted - typed).count() / edits
+                  << " ns, erase " << Nanoseconds(erased - inserted).count() / edits
+                  << " ns, streamed " << (streamed >> 20) << " MiB in " << Nanoseconds(scanned - erased).count() / 1e6
+                  << " ms; std::string insert " << Nanoseconds(flatDone - flatStart).count() / 10 / 1e6 << " ms" << std::endl;
+    }
+
+    // 10k snapshots of a large document: each one is a tree root, so saving
+    // and restoring cost the same at any size, while a string copy does not
+    {
+        const std::size_t documentSize = 32 << 20;
+        const std::size_t snapshots = 10000;
+        Editor large;
+        large.type(std::string(documentSize, 'x'));
+        std::vector<Memento> history;
+        history.reserve(snapshots);
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < snapshots; ++i) {
+            large.insert(i * 2654435761u % documentSize, "edit");
+            history.push_back(large.save());
+        }
+        auto saved = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < snapshots; ++i) {
+            large.restore(history[i * 7919 % snapshots]);
+        }
+        auto restored = std::chrono::steady_clock::now();
+        std::string flat = large.getContent().toString();
+        std::vector<std::string> copies;
+        for (int i = 0; i < 10; ++i) {
+            copies.push_back(flat);
+        }
+        auto copied = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::nano> saving = saved - start;
+        std::chrono::duration<double, std::nano> restoring = restored - saved;
+        std::chrono::duration<double, std::nano> copying = copied - restored;
+        std::cout << snapshots << " snapshots of " << (documentSize >> 20) << " MiB: edit+save "
+                  << saving.count() / snapshots << " ns, restore " << restoring.count() / snapshots
+                  << " ns; a string snapshot costs " << copying.count() / 10 / 1e6 << " ms" << std::endl;
+    }
+
     return 0;
 }
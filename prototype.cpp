@@ -1,11 +1,25 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <string>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
 
 // Prototype
 class Car {
 public:
     virtual std::unique_ptr<Car> clone() = 0;
+    // Copies this car into `storage`, which holds at least footprint() bytes
+    // aligned for any type; lets a pool clone without a heap allocation
+    virtual Car* cloneInto(void* storage) const = 0;
+    virtual std::size_t footprint() const = 0;
     virtual void printDetails() const = 0;
     virtual ~Car() {}
 };
@@ -22,11 +36,243 @@ public:
         return std::make_unique<Ford>(*this);
     }
 
+    Car* cloneInto(void* storage) const override {
+        return new (storage) Ford(*this);
+    }
+
+    std::size_t footprint() const override {
+        return sizeof(Ford);
+    }
+
     void printDetails() const override {
         std::cout << "Ford, model: " << model << std::endl;
     }
 };
 
+// A field that clones share until one of them writes to it. Copying is a
+// reference-count bump; mutate() detaches a private copy first if the block
+// is still shared.
+template <typename T>
+class CowField {
+private:
+    std::shared_ptr<T> value;
+
+public:
+    explicit CowField(T initial) : value(std::make_shared<T>(std::move(initial))) {}
+
+    const T& get() const { return *value; }
+
+    T& mutate() {
+        if (value.use_count() != 1) {
+            value = std::make_shared<T>(*value);
+        }
+        return *value;
+    }
+
+    bool sharesWith(const CowField& other) const { return value == other.value; }
+    const void* identity() const { return value.get(); }
+};
+
+// Concrete Prototype with a large configuration payload, cloned copy-on-write
+class ConfiguredFord : public Car {
+public:
+    struct Configuration {
+        std::array<std::uint8_t, 4096> options{};
+    };
+
+private:
+    CowField<std::string> model;
+    CowField<Configuration> configuration;
+
+public:
+    ConfiguredFord(std::string model, const Configuration& configuration)
+        : model(std::move(model)), configuration(configuration) {}
+
+    std::unique_ptr<Car> clone() override {
+        return std::make_unique<ConfiguredFord>(*this);
+    }
+
+    Car* cloneInto(void* storage) const override {
+        return new (storage) ConfiguredFord(*this);
+    }
+
+    std::size_t footprint() const override {
+        return sizeof(ConfiguredFord);
+    }
+
+    void setModel(std::string name) {
+        model.mutate() = std::move(name);
+    }
+
+    void setOption(std::size_t index, std::uint8_t value) {
+        configuration.mutate().options.at(index) = value;
+    }
+
+    std::uint8_t option(std::size_t index) const {
+        return configuration.get().options.at(index);
+    }
+
+    const void* configurationIdentity() const {
+        return configuration.identity();
+    }
+
+    void printDetails() const override {
+        std::cout << "Ford, model: " << model.get() << ", option 0: " << int(option(0)) << std::endl;
+    }
+};
+
+class CarPool;
+
+// Owns one pooled clone; returns its slot to the pool when dropped
+class CarHandle {
+private:
+    CarPool* pool = nullptr;
+    void* slot = nullptr;       // storage the car was built in
+    Car* car = nullptr;
+
+public:
+    CarHandle() = default;
+    CarHandle(CarPool* pool, void* slot, Car* car) : pool(pool), slot(slot), car(car) {}
+    CarHandle(CarHandle&& other) noexcept : pool(other.pool), slot(other.slot), car(other.car) {
+        other.car = nullptr;
+    }
+    CarHandle& operator=(CarHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            pool = other.pool;
+            slot = other.slot;
+            car = other.car;
+            other.car = nullptr;
+        }
+        return *this;
+    }
+    ~CarHandle() { reset(); }
+
+    void reset();
+
+    Car* get() const { return car; }
+    Car* operator->() const { return car; }
+    Car& operator*() const { return *car; }
+    explicit operator bool() const { return car != nullptr; }
+};
+
+// Fixed-size slots carved out of large slabs. Released slots go onto a free
+// list and are reused before any new slab is allocated, so steady-state
+// cloning performs no allocation at all.
+class CarPool {
+private:
+    static constexpr std::size_t slabSlots = 4096;
+
+    std::size_t slotSize;
+    std::vector<std::unique_ptr<std::max_align_t[]>> slabs;
+    std::vector<void*> freeSlots;
+    std::size_t live = 0;
+
+    void addSlab(std::size_t slots) {
+        // Default-initialised: the slots are left untouched until used
+        std::size_t words = slots * slotSize / sizeof(std::max_align_t);
+        slabs.push_back(std::unique_ptr<std::max_align_t[]>(new std::max_align_t[words]));
+        char* first = reinterpret_cast<char*>(slabs.back().get());
+        // Pushed in reverse so slots are handed out in address order
+        for (std::size_t i = slots; i-- > 0;) {
+            freeSlots.push_back(first + i * slotSize);
+        }
+    }
+
+public:
+    explicit CarPool(std::size_t footprint)
+        : slotSize((footprint + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t) * sizeof(std::max_align_t)) {}
+
+    CarPool(const CarPool&) = delete;
+    CarPool& operator=(const CarPool&) = delete;
+
+    ~CarPool() {
+        if (live != 0) {
+            std::cerr << "CarPool destroyed with " << live << " live clones" << std::endl;
+        }
+    }
+
+    // Clones `prototype` n times; clones that need fresh slots land in a
+    // single contiguous slab
+    std::vector<CarHandle> cloneN(const Car& prototype, std::size_t n) {
+        if (prototype.footprint() > slotSize) {
+            throw std::invalid_argument("prototype does not fit the pool's slots");
+        }
+        if (freeSlots.size() < n) {
+            addSlab(std::max(n - freeSlots.size(), slabSlots));
+        }
+        std::vector<CarHandle> clones;
+        clones.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            void* slot = freeSlots.back();
+            Car* car = prototype.cloneInto(slot);   // on throw the slot stays free
+            freeSlots.pop_back();
+            ++live;
+            clones.emplace_back(this, slot, car);
+        }
+        return clones;
+    }
+
+    void release(void* slot, Car* car) {
+        car->~Car();
+        freeSlots.push_back(slot);
+        --live;
+    }
+
+    std::size_t liveClones() const { return live; }
+    std::size_t slabAllocations() const { return slabs.size(); }
+};
+
+void CarHandle::reset() {
+    if (car) {
+        pool->release(slot, car);
+        car = nullptr;
+    }
+}
+
+// Prototype Registry
+class CarRegistry {
+private:
+    struct Entry {
+        std::unique_ptr<Car> prototype;
+        std::unique_ptr<CarPool> pool;
+    };
+    std::unordered_map<std::string, Entry> entries;
+
+    Entry& find(const std::string& name) {
+        auto it = entries.find(name);
+        if (it == entries.end()) {
+            throw std::out_of_range("no prototype named " + name);
+        }
+        return it->second;
+    }
+
+public:
+    // Replacing a prototype would free the slots its clones live in, so a
+    // name can only be reused once all of its pooled clones are released
+    void add(const std::string& name, std::unique_ptr<Car> prototype) {
+        auto existing = entries.find(name);
+        if (existing != entries.end() && existing->second.pool->liveClones() != 0) {
+            throw std::logic_error("prototype " + name + " still has live clones");
+        }
+        auto pool = std::make_unique<CarPool>(prototype->footprint());
+        entries[name] = Entry{std::move(prototype), std::move(pool)};
+    }
+
+    std::unique_ptr<Car> clone(const std::string& name) {
+        return find(name).prototype->clone();
+    }
+
+    std::vector<CarHandle> cloneN(const std::string& name, std::size_t n) {
+        Entry& entry = find(name);
+        return entry.pool->cloneN(*entry.prototype, n);
+    }
+
+    const CarPool& pool(const std::string& name) {
+        return *find(name).pool;
+    }
+};
+
 int main() {
     std::unique_ptr<Car> ford = std::make_unique<Ford>("Mustang");
     ford->printDetails();
@@ -35,5 +281,39 @@ int main() {
     std::unique_ptr<Car> clonedFord = ford->clone();
     clonedFord->printDetails();
 
+    // Clone by name from the registry
+    CarRegistry registry;
+    registry.add("mustang", std::move(ford));
+    registry.add("focus", std::make_unique<Ford>("Focus"));
+    registry.clone("focus")->printDetails();
+
+    // Bulk clones; releasing them recycles their slots for the next round
+    const std::size_t batch = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 5; ++round) {
+        std::vector<CarHandle> fleet = registry.cloneN("mustang", batch);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Pooled clones: " << 5 * batch << " in " << registry.pool("mustang").slabAllocations()
+              << " slab allocation(s), " << static_cast<long>(5 * batch / elapsed.count()) << " clones/s" << std::endl;
+
+    // Copy-on-write clones share one configuration until they diverge
+    ConfiguredFord::Configuration configuration;
+    configuration.options.fill(1);
+    registry.add("configured", std::make_unique<ConfiguredFord>("Explorer", configuration));
+    std::vector<CarHandle> configured = registry.cloneN("configured", batch);
+    for (std::size_t i = 0; i < batch; i += 1000) {
+        static_cast<ConfiguredFord&>(*configured[i]).setOption(0, 2);
+    }
+    std::unordered_set<const void*> payloads;
+    for (const CarHandle& car : configured) {
+        payloads.insert(static_cast<const ConfiguredFord&>(*car).configurationIdentity());
+    }
+    std::cout << "Copy-on-write clones: " << batch << " objects of " << sizeof(ConfiguredFord) << " bytes sharing "
+              << payloads.size() << " configuration(s), " << payloads.size() * sizeof(ConfiguredFord::Configuration) / 1024
+              << " KiB of payload instead of " << batch * sizeof(ConfiguredFord::Configuration) / (1024 * 1024) << " MiB" << std::endl;
+    configured[0]->printDetails();
+    configured[1]->printDetails();
+
     return 0;
 }
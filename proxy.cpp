@@ -1,5 +1,28 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 /*
 The Proxy design pattern provides a surrogate or placeholder for another object to control access 
@@ -55,6 +78,732 @@ public:
     }
 };
 
+// 'LazyProxy' Class
+// A virtual proxy: the real subject is only built on the first request,
+// by a factory that defaults to making a RealSubject. After that, reaching
+// it costs a single atomic load. With an idle timeout the subject can also
+// be dropped again by unloadIfIdle() and is rebuilt transparently the next
+// time it is needed.
+class LazyProxy : public Subject {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Factory = std::function<std::unique_ptr<Subject>()>;
+
+private:
+    mutable std::atomic<Subject*> realSubject{nullptr};
+    mutable std::mutex loadMutex;
+    Clock::duration idleTimeout;
+    Factory factory;
+
+    // Only maintained when unloading is enabled
+    mutable std::atomic<int> activeCalls{0};
+    mutable std::atomic<Clock::rep> lastUse{0};
+
+    static Clock::rep now() {
+        return Clock::now().time_since_epoch().count();
+    }
+
+    Subject* load() const {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        Subject* subject = realSubject.load(std::memory_order_acquire);
+        if (!subject) {
+            subject = factory().release();
+            // A fresh subject counts as used, or it could look idle at once
+            lastUse.store(now(), std::memory_order_relaxed);
+            realSubject.store(subject, std::memory_order_release);
+        }
+        return subject;
+    }
+
+public:
+    // A zero timeout keeps the subject for the lifetime of the proxy
+    explicit LazyProxy(Clock::duration idleTimeout = Clock::duration::zero(),
+                       Factory factory = [] { return std::make_unique<RealSubject>(); })
+        : idleTimeout(idleTimeout), factory(std::move(factory)) {}
+
+    ~LazyProxy() override {
+        delete realSubject.load();
+    }
+
+    LazyProxy(const LazyProxy&) = delete;
+    LazyProxy& operator=(const LazyProxy&) = delete;
+
+    void request() const override {
+        if (idleTimeout == Clock::duration::zero()) {
+            Subject* subject = realSubject.load(std::memory_order_acquire);
+            (subject ? subject : load())->request();
+            return;
+        }
+        // Announce the call before looking at the pointer, so an unload
+        // that has already taken the pointer waits for us to finish
+        Subject* subject;
+        while (true) {
+            activeCalls.fetch_add(1);
+            subject = realSubject.load();
+            if (subject) {
+                break;
+            }
+            activeCalls.fetch_sub(1);
+            load();
+        }
+        // Ends the call even if the subject throws, or unloading would
+        // wait for it forever
+        struct Finish {
+            const LazyProxy& proxy;
+            ~Finish() {
+                proxy.lastUse.store(now(), std::memory_order_relaxed);
+                proxy.activeCalls.fetch_sub(1, std::memory_order_release);
+            }
+        } finish{*this};
+        subject->request();
+    }
+
+    // Destroys the subject if it has not been used for the idle timeout
+    bool unloadIfIdle() const {
+        if (idleTimeout == Clock::duration::zero()) {
+            return false;
+        }
+        Clock::time_point used{Clock::duration(lastUse.load(std::memory_order_relaxed))};
+        if (Clock::now() - used < idleTimeout) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(loadMutex);
+        Subject* subject = realSubject.exchange(nullptr);
+        if (!subject) {
+            return false;
+        }
+        while (activeCalls.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        delete subject;
+        return true;
+    }
+
+    bool isLoaded() const {
+        return realSubject.load(std::memory_order_acquire) != nullptr;
+    }
+};
+
+// 'RateLimiter' shared by protection proxies. Every key has its own bucket
+// on its own cache line; admitting a request touches only atomics of that
+// bucket and a request that is over the limit is rejected by plain loads.
+//
+// The rate is enforced with GCRA, the single-counter form of a token
+// bucket: `theoreticalArrival` is when the bucket would be full again.
+class RateLimiter {
+public:
+    struct Limit {
+        double requestsPerSecond;
+        std::uint32_t burst;
+        std::uint32_t maxConcurrent;
+    };
+
+    struct alignas(64) Bucket {
+        std::atomic<std::int64_t> theoreticalArrival{0};
+        std::atomic<std::uint32_t> inFlight{0};
+        std::atomic<std::uint64_t> rejected{0};
+        std::int64_t interval;      // nanoseconds per request
+        std::int64_t tolerance;     // how far ahead of now the schedule may run
+        std::uint32_t maxConcurrent;
+    };
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<Bucket>> buckets;
+
+    static std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    // Keys must be registered, once each, before any proxy looks them up.
+    // The rate must be positive and allow at least one request per ~30
+    // years; at least one request must be allowed in flight.
+    void addKey(const std::string& key, const Limit& limit) {
+        std::uint32_t burst = std::max<std::uint32_t>(limit.burst, 1);
+        double interval = 1e9 / limit.requestsPerSecond;
+        if (!(limit.requestsPerSecond > 0) || !(interval * burst <= 1e18) || limit.maxConcurrent == 0) {
+            throw std::invalid_argument("invalid rate limit for key " + key);
+        }
+        if (buckets.count(key) != 0) {
+            throw std::invalid_argument("rate limit key already registered: " + key);
+        }
+        auto bucket = std::make_unique<Bucket>();
+        bucket->interval = std::max<std::int64_t>(static_cast<std::int64_t>(interval), 1);
+        bucket->tolerance = bucket->interval * burst;
+        bucket->maxConcurrent = limit.maxConcurrent;
+        buckets.emplace(key, std::move(bucket));
+    }
+
+    Bucket* bucketFor(const std::string& key) const {
+        auto found = buckets.find(key);
+        return found == buckets.end() ? nullptr : found->second.get();
+    }
+
+    static bool tryAcquire(Bucket& bucket) {
+        std::int64_t t = now();
+        std::int64_t arrival = bucket.theoreticalArrival.load(std::memory_order_relaxed);
+        if (std::max(arrival, t) + bucket.interval - t > bucket.tolerance ||
+            bucket.inFlight.load(std::memory_order_relaxed) >= bucket.maxConcurrent) {
+            bucket.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (bucket.inFlight.fetch_add(1, std::memory_order_acquire) >= bucket.maxConcurrent) {
+            bucket.inFlight.fetch_sub(1, std::memory_order_relaxed);
+            bucket.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        while (true) {
+            std::int64_t next = std::max(arrival, t) + bucket.interval;
+            if (next - t > bucket.tolerance) {
+                bucket.inFlight.fetch_sub(1, std::memory_order_relaxed);
+                bucket.rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (bucket.theoreticalArrival.compare_exchange_weak(arrival, next, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    static void release(Bucket& bucket) {
+        bucket.inFlight.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+// 'ProtectionProxy' Class
+// Admits requests for one key according to the shared RateLimiter and sheds
+// the rest immediately, without ever reaching the real subject.
+class ProtectionProxy : public Subject {
+private:
+    std::shared_ptr<Subject> subject;
+    RateLimiter::Bucket* bucket;
+
+public:
+    // Throws if `key` was never registered with the limiter
+    ProtectionProxy(const RateLimiter& limiter, const std::string& key, std::shared_ptr<Subject> subject)
+        : subject(std::move(subject)), bucket(limiter.bucketFor(key)) {
+        if (!bucket) {
+            throw std::invalid_argument("no rate limit registered for key " + key);
+        }
+    }
+
+    // Returns false when the request was shed
+    bool tryRequest() const {
+        if (!RateLimiter::tryAcquire(*bucket)) {
+            return false;
+        }
+        struct Release {
+            RateLimiter::Bucket& bucket;
+            ~Release() { RateLimiter::release(bucket); }
+        } release{*bucket};
+        subject->request();
+        return true;
+    }
+
+    void request() const override {
+        tryRequest();
+    }
+
+    std::uint64_t rejectedCount() const {
+        return bucket->rejected.load(std::memory_order_relaxed);
+    }
+};
+
+// 'Subject' Interface for request/response style services
+class QuerySubject {
+public:
+    virtual std::string query(const std::string& key) const = 0;
+    virtual ~QuerySubject() {}
+};
+
+// 'RealSubject' whose answers are slow to compute
+class RealQuerySubject : public QuerySubject {
+private:
+    mutable std::atomic<int> calls{0};
+
+public:
+    std::string query(const std::string& key) const override {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return "result for " + key;
+    }
+
+    int callCount() const {
+        return calls;
+    }
+};
+
+// 'CachingProxy' Class
+// Remembers up to `capacity` results for `ttl`, evicting the least recently
+// used first. Concurrent misses for the same key are coalesced: only the
+// first caller reaches the real subject, the others wait for its result.
+class CachingProxy : public QuerySubject {
+public:
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t coalesced;
+        std::chrono::nanoseconds averageLatency;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        std::string value;
+        Clock::time_point expires;
+    };
+
+    std::shared_ptr<QuerySubject> subject;
+    std::size_t capacity;
+    Clock::duration ttl;
+
+    mutable std::mutex mutex;
+    mutable std::list<Entry> entries;   // most recently used first
+    mutable std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    mutable std::unordered_map<std::string, std::shared_future<std::string>> inFlight;
+
+    mutable std::atomic<std::uint64_t> hits{0};
+    mutable std::atomic<std::uint64_t> misses{0};
+    mutable std::atomic<std::uint64_t> coalesced{0};
+    mutable std::atomic<std::uint64_t> totalNanos{0};
+
+    void recordLatency(Clock::time_point start) const {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        totalNanos += static_cast<std::uint64_t>(elapsed.count());
+    }
+
+    // Called with `lock` held; the real subject is queried without it
+    std::string fetch(const std::string& key, std::unique_lock<std::mutex>& lock) const {
+        std::promise<std::string> result;
+        inFlight.emplace(key, result.get_future().share());
+        lock.unlock();
+        std::string value;
+        try {
+            value = subject->query(key);
+        } catch (...) {
+            lock.lock();
+            inFlight.erase(key);
+            lock.unlock();
+            result.set_exception(std::current_exception());
+            throw;
+        }
+        lock.lock();
+        entries.push_front(Entry{key, value, Clock::now() + ttl});
+        index[key] = entries.begin();
+        if (entries.size() > capacity) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+        inFlight.erase(key);
+        lock.unlock();
+        result.set_value(value);
+        return value;
+    }
+
+public:
+    CachingProxy(std::shared_ptr<QuerySubject> subject, std::size_t capacity, Clock::duration ttl)
+        : subject(std::move(subject)), capacity(std::max<std::size_t>(capacity, 1)), ttl(ttl) {}
+
+    std::string query(const std::string& key) const override {
+        auto start = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        auto cached = index.find(key);
+        if (cached != index.end()) {
+            if (cached->second->expires > start) {
+                entries.splice(entries.begin(), entries, cached->second);
+                std::string value = cached->second->value;
+                lock.unlock();
+                ++hits;
+                recordLatency(start);
+                return value;
+            }
+            entries.erase(cached->second);
+            index.erase(cached);
+        }
+        auto pending = inFlight.find(key);
+        if (pending != inFlight.end()) {
+            std::shared_future<std::string> result = pending->second;
+            lock.unlock();
+            ++coalesced;
+            std::string value = result.get();
+            recordLatency(start);
+            return value;
+        }
+        ++misses;
+        std::string value = fetch(key, lock);
+        recordLatency(start);
+        return value;
+    }
+
+    Stats stats() const {
+        std::uint64_t calls = hits + misses + coalesced;
+        return Stats{hits, misses, coalesced,
+                     std::chrono::nanoseconds(calls ? totalNanos / calls : 0)};
+    }
+};
+
+// Remote proxy wire protocol over a Unix domain socket. Frames have a
+// fixed size and are written in native byte order (both ends share a host):
+//   request:  u64 id | u8 op
+//   response: u64 id | u8 status
+// Requests are pipelined: the client never waits for a response before
+// sending the next one, and responses are matched back to callers by id.
+namespace wire {
+    constexpr std::uint8_t opRequest = 1;
+    constexpr std::uint8_t statusOk = 0;
+    constexpr std::uint8_t statusFailed = 1;
+    constexpr std::size_t frameSize = sizeof(std::uint64_t) + 1;
+
+    inline void putFrame(std::vector<char>& out, std::uint64_t id, std::uint8_t code) {
+        char frame[frameSize];
+        std::memcpy(frame, &id, sizeof(id));
+        frame[sizeof(id)] = static_cast<char>(code);
+        out.insert(out.end(), frame, frame + frameSize);
+    }
+
+    inline std::pair<std::uint64_t, std::uint8_t> getFrame(const char* in) {
+        std::uint64_t id;
+        std::memcpy(&id, in, sizeof(id));
+        return {id, static_cast<std::uint8_t>(in[sizeof(id)])};
+    }
+
+    inline bool writeAll(int fd, const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+}
+
+// Serves a real subject to remote proxies. Each read may carry many
+// pipelined requests; all of their responses go back in a single write.
+class SubjectServer {
+private:
+    std::shared_ptr<Subject> subject;
+
+    static void serveConnection(Subject& subject, int fd) {
+        std::vector<char> in(64 * 1024);
+        std::size_t have = 0;
+        std::vector<char> out;
+        while (true) {
+            ssize_t count = ::read(fd, in.data() + have, in.size() - have);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            have += static_cast<std::size_t>(count);
+            std::size_t used = 0;
+            out.clear();
+            for (; have - used >= wire::frameSize; used += wire::frameSize) {
+                auto frame = wire::getFrame(in.data() + used);
+                std::uint8_t status = wire::statusFailed;
+                if (frame.second == wire::opRequest) {
+                    try {
+                        subject.request();
+                        status = wire::statusOk;
+                    } catch (...) {
+                    }
+                }
+                wire::putFrame(out, frame.first, status);
+            }
+            std::memmove(in.data(), in.data() + used, have - used);
+            have -= used;
+            if (!wire::writeAll(fd, out.data(), out.size())) {
+                break;
+            }
+        }
+        ::close(fd);
+    }
+
+public:
+    explicit SubjectServer(std::shared_ptr<Subject> subject) : subject(std::move(subject)) {}
+
+    // Handles one connection until the client hangs up, then closes it
+    void serve(int fd) const {
+        serveConnection(*subject, fd);
+    }
+
+    // Accepts connections on `path`, serving each on its own detached
+    // thread. Those threads share ownership of the subject, so they stay
+    // valid even if this server object goes away first.
+    void listen(const std::string& path) const {
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot listen on " + path);
+        }
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(path.c_str());
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listener, SOMAXCONN) != 0) {
+            int error = errno;
+            ::close(listener);
+            throw std::system_error(error, std::generic_category(), "cannot listen on " + path);
+        }
+        while (true) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            std::thread([subject = subject, fd] { serveConnection(*subject, fd); }).detach();
+        }
+        ::close(listener);
+    }
+};
+
+// In-process stand-in for a remote server, connected through a socketpair.
+// Lets tests exercise the full protocol without a second process.
+class LocalSubjectServer {
+private:
+    SubjectServer server;
+    int clientFd = -1;
+    std::thread thread;
+
+public:
+    explicit LocalSubjectServer(std::shared_ptr<Subject> subject) : server(std::move(subject)) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            throw std::system_error(errno, std::generic_category(), "socketpair failed");
+        }
+        clientFd = fds[0];
+        thread = std::thread([this, fd = fds[1]] { server.serve(fd); });
+    }
+
+    // The server runs until the client end is closed: by the proxy that took
+    // it, or here if no proxy ever did
+    ~LocalSubjectServer() {
+        if (clientFd >= 0) {
+            ::close(clientFd);
+        }
+        thread.join();
+    }
+
+    int takeClient() {
+        return std::exchange(clientFd, -1);
+    }
+};
+
+// 'RemoteProxy' Class
+// Stands in for a subject living in another process. Calls are queued and
+// a writer thread sends everything queued so far in one write, so many
+// small requests share a syscall; a reader thread completes the callers.
+class RemoteProxy : public Subject {
+private:
+    int fd;
+    mutable std::mutex mutex;
+    mutable std::condition_variable wake;
+    mutable std::vector<char> outgoing;
+    mutable std::unordered_map<std::uint64_t, std::promise<void>> pending;
+    mutable std::uint64_t nextId = 0;
+    bool closing = false;
+    bool broken = false;
+    std::thread writer;
+    std::thread reader;
+
+    void writeLoop() {
+        std::vector<char> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return closing || !outgoing.empty(); });
+            if (outgoing.empty()) {
+                break;
+            }
+            batch.swap(outgoing);
+            lock.unlock();
+            bool sent = wire::writeAll(fd, batch.data(), batch.size());
+            batch.clear();
+            lock.lock();
+            if (!sent) {
+                break;
+            }
+        }
+        lock.unlock();
+        ::shutdown(fd, SHUT_WR);
+    }
+
+    void readLoop() {
+        std::vector<char> in(64 * 1024);
+        std::size_t have = 0;
+        while (true) {
+            ssize_t count = ::read(fd, in.data() + have, in.size() - have);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            have += static_cast<std::size_t>(count);
+            std::size_t used = 0;
+            std::lock_guard<std::mutex> lock(mutex);
+            for (; have - used >= wire::frameSize; used += wire::frameSize) {
+                auto frame = wire::getFrame(in.data() + used);
+                auto waiting = pending.find(frame.first);
+                if (waiting == pending.end()) {
+                    continue;
+                }
+                if (frame.second == wire::statusOk) {
+                    waiting->second.set_value();
+                } else {
+                    waiting->second.set_exception(std::make_exception_ptr(
+                        std::runtime_error("remote request failed")));
+                }
+                pending.erase(waiting);
+            }
+            std::memmove(in.data(), in.data() + used, have - used);
+            have -= used;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        broken = true;
+        for (auto& waiting : pending) {
+            waiting.second.set_exception(std::make_exception_ptr(
+                std::runtime_error("connection to remote subject lost")));
+        }
+        pending.clear();
+    }
+
+public:
+    // Takes ownership of a connected stream socket, closing it even if the
+    // proxy cannot be started
+    explicit RemoteProxy(int fd) : fd(fd) {
+        try {
+            writer = std::thread(&RemoteProxy::writeLoop, this);
+            reader = std::thread(&RemoteProxy::readLoop, this);
+        } catch (...) {
+            if (writer.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    closing = true;
+                }
+                wake.notify_all();
+                writer.join();
+            }
+            ::close(fd);
+            throw;
+        }
+    }
+
+    static std::unique_ptr<RemoteProxy> connect(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            throw std::system_error(error, std::generic_category(), "cannot connect to " + path);
+        }
+        return std::make_unique<RemoteProxy>(fd);
+    }
+
+    // Flushes queued requests, waits for their responses and disconnects
+    ~RemoteProxy() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        wake.notify_one();
+        writer.join();
+        reader.join();
+        ::close(fd);
+    }
+
+    RemoteProxy(const RemoteProxy&) = delete;
+    RemoteProxy& operator=(const RemoteProxy&) = delete;
+
+    // Sends the request without waiting; the future completes on response
+    std::future<void> requestAsync() const {
+        std::promise<void> response;
+        std::future<void> result = response.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (broken || closing) {
+                response.set_exception(std::make_exception_ptr(
+                    std::runtime_error("connection to remote subject lost")));
+                return result;
+            }
+            std::uint64_t id = nextId++;
+            pending.emplace(id, std::move(response));
+            wire::putFrame(outgoing, id, wire::opRequest);
+        }
+        wake.notify_one();
+        return result;
+    }
+
+    void request() const override {
+        requestAsync().get();
+    }
+};
+
+// Stand-in for a subject that is costly to build: it fills 16 KiB of state
+class ExpensiveSubject : public Subject {
+private:
+    std::vector<std::uint64_t> state;
+    mutable std::atomic<std::uint64_t> served{0};
+
+public:
+    ExpensiveSubject() : state(2048) {
+        for (std::size_t i = 0; i < state.size(); ++i) {
+            state[i] = i * 0x9E3779B97F4A7C15ull;
+        }
+    }
+
+    void request() const override {
+        served.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// Resident set size of this process, from /proc/self/statm
+long long residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    long long pages = 0;
+    long long resident = 0;
+    statm >> pages >> resident;
+    return resident * ::sysconf(_SC_PAGESIZE);
+}
+
+// Wall time of one run of `job`, in milliseconds
+template <typename F>
+double millisecondsFor(F&& job) {
+    auto start = std::chrono::steady_clock::now();
+    job();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Wall time of each of `calls` runs of `job`, sorted, in nanoseconds
+template <typename F>
+std::vector<double> sortedLatencies(std::size_t calls, F&& job) {
+    std::vector<double> latencies;
+    latencies.reserve(calls);
+    for (std::size_t i = 0; i < calls; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        job();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        latencies.push_back(elapsed.count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
 // Client code
 void clientCode(const Subject& subject) {
     // ...
@@ -65,5 +814,171 @@ void clientCode(const Subject& subject) {
 int main() {
     Proxy proxy;
     clientCode(proxy);
+
+    // Lazy proxies cost almost nothing until one is actually used
+    std::vector<std::unique_ptr<LazyProxy>> lazyProxies;
+    for (int i = 0; i < 100; ++i) {
+        lazyProxies.push_back(std::make_unique<LazyProxy>(std::chrono::milliseconds(10)));
+    }
+    clientCode(*lazyProxies[42]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool unloaded = lazyProxies[42]->unloadIfIdle();
+    std::cout << "LazyProxy: subject unloaded after idling: " << std::boolalpha << unloaded
+              << ", still loaded: " << lazyProxies[42]->isLoaded() << std::endl;
+
+    // Startup cost of 10k expensive subjects of which 1% are ever used:
+    // behind lazy proxies against constructing them all up front
+    {
+        const std::size_t count = 10000;
+        LazyProxy::Factory expensive = [] { return std::make_unique<ExpensiveSubject>(); };
+        std::vector<std::unique_ptr<LazyProxy>> lazy;
+        long long before = residentBytes();
+        double lazyStartup = millisecondsFor([&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                lazy.push_back(std::make_unique<LazyProxy>(LazyProxy::Clock::duration::zero(), expensive));
+            }
+        });
+        double lazyUse = millisecondsFor([&] {
+            for (std::size_t i = 0; i < count; i += 100) {
+                lazy[i]->request();
+            }
+        });
+        long long lazyResident = residentBytes() - before;
+        lazy.clear();
+
+        std::vector<std::unique_ptr<Subject>> eager;
+        before = residentBytes();
+        double eagerStartup = millisecondsFor([&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                eager.push_back(expensive());
+            }
+        });
+        double eagerUse = millisecondsFor([&] {
+            for (std::size_t i = 0; i < count; i += 100) {
+                eager[i]->request();
+            }
+        });
+        long long eagerResident = residentBytes() - before;
+        std::cout << "LazyProxy: " << count << " subjects, 1% used: startup " << lazyStartup << " ms, first use "
+                  << lazyUse << " ms, RSS +" << lazyResident / 1024 << " KiB; eager: startup " << eagerStartup
+                  << " ms, first use " << eagerUse << " ms, RSS +" << eagerResident / 1024 << " KiB" << std::endl;
+    }
+
+    // A burst beyond the configured limit is shed by the protection proxy
+    RateLimiter limiter;
+    limiter.addKey("client-a", RateLimiter::Limit{5.0, 3, 2});
+    ProtectionProxy guarded(limiter, "client-a", std::make_shared<RealSubject>());
+    int admitted = 0;
+    for (int i = 0; i < 5; ++i) {
+        admitted += guarded.tryRequest();
+    }
+    std::cout << "ProtectionProxy: " << admitted << " admitted, " << guarded.rejectedCount()
+              << " rejected" << std::endl;
+
+    // Admission cost with 8 threads hammering one key, once far over its
+    // limit (nearly all shed) and once under it (nearly all admitted).
+    // The figure is wall time over all calls, so it falls as cores are added
+    {
+        const std::size_t threads = 8;
+        const std::size_t callsPerThread = 1000000;
+        RateLimiter contended;
+        contended.addKey("shed", RateLimiter::Limit{1000.0, 10, 4});
+        contended.addKey("admit", RateLimiter::Limit{1e9, 1000000, 64});
+        auto silent = std::make_shared<ExpensiveSubject>();
+        for (const char* key : {"shed", "admit"}) {
+            ProtectionProxy hot(contended, key, silent);
+            std::atomic<std::size_t> admittedCalls{0};
+            std::atomic<bool> go{false};
+            std::vector<std::thread> callers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                callers.emplace_back([&] {
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    std::size_t mine = 0;
+                    for (std::size_t i = 0; i < callsPerThread; ++i) {
+                        mine += hot.tryRequest();
+                    }
+                    admittedCalls.fetch_add(mine);
+                });
+            }
+            double elapsed = millisecondsFor([&] {
+                go.store(true, std::memory_order_release);
+                for (auto& caller : callers) {
+                    caller.join();
+                }
+            });
+            std::size_t calls = threads * callsPerThread;
+            std::cout << "ProtectionProxy: " << threads << " threads, key \"" << key << "\": "
+                      << elapsed * 1e6 / calls << " ns per tryRequest (" << admittedCalls << " admitted, "
+                      << hot.rejectedCount() << " rejected)" << std::endl;
+        }
+    }
+
+    // Repeated queries are answered by the caching proxy
+    auto backend = std::make_shared<RealQuerySubject>();
+    CachingProxy cache(backend, 128, std::chrono::seconds(30));
+    std::vector<std::thread> clients;
+    for (int i = 0; i < 8; ++i) {
+        clients.emplace_back([&cache] { cache.query("status"); });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    std::cout << cache.query("status") << std::endl;
+
+    CachingProxy::Stats stats = cache.stats();
+    std::cout << "CachingProxy: " << stats.hits << " hits, " << stats.misses << " misses, "
+              << stats.coalesced << " coalesced, backend called " << backend->callCount()
+              << " time(s)" << std::endl;
+
+    // The same Subject served from behind a socket, with pipelined calls
+    LocalSubjectServer server(std::make_shared<RealSubject>());
+    RemoteProxy remote(server.takeClient());
+    clientCode(remote);
+    std::vector<std::future<void>> inFlight;
+    for (int i = 0; i < 3; ++i) {
+        inFlight.push_back(remote.requestAsync());
+    }
+    for (auto& response : inFlight) {
+        response.get();
+    }
+    std::cout << "RemoteProxy: all pipelined requests answered" << std::endl;
+
+    // Round trips one at a time for latency, then windows of pipelined
+    // requests for throughput, each against calling the subject in-process
+    {
+        auto silent = std::make_shared<ExpensiveSubject>();
+        LocalSubjectServer benchServer(silent);
+        RemoteProxy benchRemote(benchServer.takeClient());
+        const std::size_t calls = 20000;
+        std::vector<double> local = sortedLatencies(calls, [&] { silent->request(); });
+        std::vector<double> remoteCalls = sortedLatencies(calls, [&] { benchRemote.request(); });
+        std::cout << "RemoteProxy: latency p50 " << remoteCalls[calls / 2] << " ns, p99 "
+                  << remoteCalls[calls * 99 / 100] << " ns; in-process p50 " << local[calls / 2]
+                  << " ns, p99 " << local[calls * 99 / 100] << " ns" << std::endl;
+
+        const std::size_t window = 256;
+        const std::size_t total = window * 800;
+        double localElapsed = millisecondsFor([&] {
+            for (std::size_t i = 0; i < total; ++i) {
+                silent->request();
+            }
+        });
+        std::vector<std::future<void>> responses;
+        double remoteElapsed = millisecondsFor([&] {
+            for (std::size_t sent = 0; sent < total; sent += window) {
+                responses.clear();
+                for (std::size_t i = 0; i < window; ++i) {
+                    responses.push_back(benchRemote.requestAsync());
+                }
+                for (auto& response : responses) {
+                    response.get();
+                }
+            }
+        });
+        std::cout << "RemoteProxy: " << total / remoteElapsed * 1e3 << " requests/s pipelined " << window
+                  << " deep; in-process " << total / localElapsed * 1e3 << " calls/s" << std::endl;
+    }
     return 0;
 }
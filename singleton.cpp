@@ -1,4 +1,23 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
 
 /*
 The Singleton design pattern ensures that a class has only one instance and provides a global point of access to it.
@@ -10,11 +29,386 @@ Key Aspects:
 - Controlled initialization: The creation of the instance is controlled within the class.
 */
 
+// SingletonHolder - reusable, thread-safe owner of the unique instance of T.
+// The first call creates the instance under a lock; every later call is a
+// single acquire load. T only needs to befriend SingletonHolder<T>.
+template <typename T>
+class SingletonHolder {
+private:
+    inline static std::atomic<T*> instance{nullptr};
+    inline static std::mutex mutex;
+    // Bumped by destroy() so per-thread cached pointers know they are stale
+    inline static std::atomic<std::uint64_t> generation{1};
+
+    struct ThreadCache {
+        T* pointer = nullptr;
+        std::uint64_t generation = 0;
+    };
+    inline static thread_local ThreadCache cache;
+
+    static T& create() {
+        std::lock_guard<std::mutex> lock(mutex);
+        T* existing = instance.load(std::memory_order_relaxed);
+        if (!existing) {
+            existing = new T();
+            instance.store(existing, std::memory_order_release);
+        }
+        return *existing;
+    }
+
+public:
+    static T& get() {
+        T* existing = instance.load(std::memory_order_acquire);
+        return existing ? *existing : create();
+    }
+
+    // Same as get(), but remembers the pointer in a thread_local so repeat
+    // calls from one thread only compare against the shared generation
+    static T& getCached() {
+        std::uint64_t current = generation.load(std::memory_order_acquire);
+        if (cache.generation != current) {
+            cache.pointer = &get();
+            cache.generation = current;
+        }
+        return *cache.pointer;
+    }
+
+    // Deterministic teardown; callers must ensure nobody still uses the
+    // instance. A later get() creates a fresh one.
+    static void destroy() {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation.fetch_add(1, std::memory_order_acq_rel);
+        delete instance.exchange(nullptr, std::memory_order_acq_rel);
+    }
+};
+
+// ThreadScoped / NodeScoped - singleton-style access to hot mutable state
+// without one shared instance. local() hands out the instance belonging to
+// the calling thread (or to the NUMA node it runs on), so updates stay in
+// that core's (or node's) caches; reduce() merges all instances for reads.
+// Instances live until program exit, so work done by finished threads is
+// still counted. Fields that reduce() reads while owners update them
+// should be atomics (relaxed is enough).
+template <typename T>
+class ThreadScoped {
+private:
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    inline static std::mutex mutex;
+    inline static std::vector<std::unique_ptr<Slot>> slots;
+
+    static T& registerThread() {
+        auto slot = std::make_unique<Slot>();
+        T& value = slot->value;
+        std::lock_guard<std::mutex> lock(mutex);
+        slots.push_back(std::move(slot));
+        return value;
+    }
+
+public:
+    static T& local() {
+        thread_local T& value = registerThread();
+        return value;
+    }
+
+    template <typename R, typename Combine>
+    static R reduce(R initial, Combine combine) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& slot : slots) {
+            initial = combine(std::move(initial), slot->value);
+        }
+        return initial;
+    }
+};
+
+// One instance per NUMA node, shared by the threads running there, so T
+// must itself be thread-safe. Each instance is created by the first thread
+// that asks for it on its node, which places it in that node's memory.
+template <typename T>
+class NodeScoped {
+private:
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    // Threads re-check which node they run on every this many calls
+    static constexpr unsigned refreshInterval = 1024;
+
+    static std::size_t nodeCount() {
+        static const std::size_t count = [] {
+            // e.g. "0-3" or "0"
+            std::ifstream possible("/sys/devices/system/node/possible");
+            std::string range;
+            if (!(possible >> range)) {
+                return std::size_t{1};
+            }
+            auto dash = range.find('-');
+            return dash == std::string::npos ? std::size_t{1}
+                                             : static_cast<std::size_t>(std::stoul(range.substr(dash + 1)) + 1);
+        }();
+        return count;
+    }
+
+    // Slots are published lock-free by compare-and-swap and deleted by this
+    // owner at exit, like ThreadScoped's
+    struct Slots {
+        std::vector<std::atomic<Slot*>> nodes;
+
+        explicit Slots(std::size_t count) : nodes(count) {}
+        ~Slots() {
+            for (auto& entry : nodes) {
+                delete entry.load(std::memory_order_acquire);
+            }
+        }
+    };
+
+    static std::vector<std::atomic<Slot*>>& slots() {
+        static Slots owner(nodeCount());
+        return owner.nodes;
+    }
+
+    static std::size_t currentNode() {
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= nodeCount()) {
+            return 0;
+        }
+        return node;
+    }
+
+public:
+    static T& local() {
+        struct Cache {
+            Slot* slot = nullptr;
+            unsigned calls = 0;
+        };
+        thread_local Cache cache;
+        if (cache.slot && ++cache.calls % refreshInterval != 0) {
+            return cache.slot->value;
+        }
+        std::atomic<Slot*>& entry = slots()[currentNode()];
+        Slot* slot = entry.load(std::memory_order_acquire);
+        if (!slot) {
+            Slot* created = new Slot();
+            if (entry.compare_exchange_strong(slot, created, std::memory_order_acq_rel)) {
+                slot = created;
+            } else {
+                delete created;
+            }
+        }
+        cache.slot = slot;
+        return slot->value;
+    }
+
+    static std::size_t nodes() {
+        return nodeCount();
+    }
+
+    template <typename R, typename Combine>
+    static R reduce(R initial, Combine combine) {
+        for (auto& entry : slots()) {
+            if (Slot* slot = entry.load(std::memory_order_acquire)) {
+                initial = combine(std::move(initial), slot->value);
+            }
+        }
+        return initial;
+    }
+};
+
+// ServiceRegistry - a home for many singleton-like services that depend on
+// one another. Each service declares its dependencies; the registry checks
+// that they form a DAG and then either starts everything up front, running
+// independent services in parallel, or builds each one lazily on first
+// get(). Either way every service is constructed exactly once, after all
+// of its dependencies.
+class ServiceRegistry {
+public:
+    template <typename T>
+    using Factory = std::function<std::shared_ptr<T>(ServiceRegistry&)>;
+
+private:
+    struct Service {
+        std::string name;
+        std::vector<std::string> dependencies;
+        Factory<void> factory;
+        std::mutex mutex;
+        std::atomic<bool> ready{false};
+        std::shared_ptr<void> instance;
+        std::chrono::nanoseconds initTime{0};
+    };
+
+    std::map<std::string, std::unique_ptr<Service>> services;
+    std::mutex validationMutex;
+    bool validated = false;
+
+    Service& find(const std::string& name) {
+        auto found = services.find(name);
+        if (found == services.end()) {
+            throw std::runtime_error("unknown service: " + name);
+        }
+        return *found->second;
+    }
+
+    // Depth-first search with colours; throws on the first cycle found
+    void validate() {
+        enum class Mark { Unvisited, InProgress, Done };
+        std::map<const Service*, Mark> marks;
+        std::vector<std::string> path;
+        std::function<void(Service&)> visit = [&](Service& service) {
+            Mark& mark = marks[&service];
+            if (mark == Mark::Done) {
+                return;
+            }
+            path.push_back(service.name);
+            if (mark == Mark::InProgress) {
+                std::string cycle;
+                for (auto it = std::find(path.begin(), path.end(), service.name); it != path.end(); ++it) {
+                    cycle += (cycle.empty() ? "" : " -> ") + *it;
+                }
+                throw std::runtime_error("dependency cycle: " + cycle);
+            }
+            mark = Mark::InProgress;
+            for (const std::string& dependency : service.dependencies) {
+                visit(find(dependency));
+            }
+            marks[&service] = Mark::Done;
+            path.pop_back();
+        };
+        for (auto& entry : services) {
+            visit(*entry.second);
+        }
+    }
+
+    void ensureValidated() {
+        std::lock_guard<std::mutex> lock(validationMutex);
+        if (!validated) {
+            validate();
+            validated = true;
+        }
+    }
+
+    // Builds the service once; a throwing factory leaves it unbuilt so a
+    // later call can retry. Locks are only taken along DAG edges, so
+    // concurrent initialization cannot deadlock.
+    void initialize(Service& service) {
+        if (service.ready.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(service.mutex);
+        if (service.ready.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for (const std::string& dependency : service.dependencies) {
+            initialize(find(dependency));
+        }
+        auto start = std::chrono::steady_clock::now();
+        service.instance = service.factory(*this);
+        service.initTime = std::chrono::steady_clock::now() - start;
+        service.ready.store(true, std::memory_order_release);
+    }
+
+public:
+    // Registration must be finished before any get() or startAll()
+    template <typename T>
+    void add(const std::string& name, std::vector<std::string> dependencies, Factory<T> factory) {
+        auto service = std::make_unique<Service>();
+        service->name = name;
+        service->dependencies = std::move(dependencies);
+        service->factory = [factory](ServiceRegistry& registry) -> std::shared_ptr<void> {
+            return factory(registry);
+        };
+        services[name] = std::move(service);
+    }
+
+    // Returns the service, building it and its dependencies if needed
+    template <typename T>
+    std::shared_ptr<T> get(const std::string& name) {
+        ensureValidated();
+        Service& service = find(name);
+        initialize(service);
+        return std::static_pointer_cast<T>(service.instance);
+    }
+
+    // Builds every service on `threads` workers. A service is scheduled as
+    // soon as its last dependency is ready, so independent ones overlap.
+    void startAll(std::size_t threads) {
+        ensureValidated();
+
+        std::map<Service*, std::size_t> waitingOn;
+        std::map<Service*, std::vector<Service*>> dependents;
+        std::deque<Service*> ready;
+        for (auto& entry : services) {
+            Service* service = entry.second.get();
+            waitingOn[service] = service->dependencies.size();
+            for (const std::string& dependency : service->dependencies) {
+                dependents[&find(dependency)].push_back(service);
+            }
+            if (service->dependencies.empty()) {
+                ready.push_back(service);
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t remaining = services.size();
+        std::exception_ptr failure;
+        auto work = [&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [&] { return !ready.empty() || remaining == 0 || failure; });
+                if (remaining == 0 || failure) {
+                    return;
+                }
+                Service* service = ready.front();
+                ready.pop_front();
+                lock.unlock();
+                try {
+                    initialize(*service);
+                } catch (...) {
+                    lock.lock();
+                    failure = std::current_exception();
+                    changed.notify_all();
+                    return;
+                }
+                lock.lock();
+                --remaining;
+                for (Service* dependent : dependents[service]) {
+                    if (--waitingOn[dependent] == 0) {
+                        ready.push_back(dependent);
+                    }
+                }
+                changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+            workers.emplace_back(work);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    void report(std::ostream& out) const {
+        for (const auto& entry : services) {
+            const Service& service = *entry.second;
+            out << "  " << service.name << ": "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(service.initTime).count()
+                << " ms" << (service.ready ? "" : " (not started)") << std::endl;
+        }
+    }
+};
+
 // Singleton Class
 class Singleton {
 private:
-    // The unique instance of Singleton
-    static Singleton* instance;
+    friend class SingletonHolder<Singleton>;
 
     // Private Constructor to prevent instancing
     Singleton() {}
@@ -22,10 +416,7 @@ private:
 public:
     // Method to get the unique instance of Singleton
     static Singleton* getInstance() {
-        if (instance == nullptr) {
-            instance = new Singleton();
-        }
-        return instance;
+        return &SingletonHolder<Singleton>::get();
     }
 
     // Example method
@@ -38,12 +429,139 @@ public:
     Singleton& operator=(const Singleton&) = delete;
 };
 
-// Initialize static member
-Singleton* Singleton::instance = nullptr;
+// Example services that are slow to construct
+struct Config {
+    Config() { std::this_thread::sleep_for(std::chrono::milliseconds(40)); }
+};
+
+struct Logger {
+    explicit Logger(std::shared_ptr<Config>) { std::this_thread::sleep_for(std::chrono::milliseconds(40)); }
+};
+
+struct Database {
+    explicit Database(std::shared_ptr<Config>) { std::this_thread::sleep_for(std::chrono::milliseconds(40)); }
+};
+
+// Hot state updated from many threads
+struct HitCounter {
+    std::atomic<std::uint64_t> hits{0};
+};
+
+// Runs `job(n)` for n < `calls` on each of `threads` threads released
+// together; returns wall time per call across all threads, in nanoseconds
+template <typename F>
+double nanosecondsPerCall(std::size_t threads, std::size_t calls, F job) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (std::size_t n = 0; n < calls; ++n) {
+                job(n);
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (threads * calls);
+}
 
 // Client code
 int main() {
     Singleton* singleton = Singleton::getInstance();
     singleton->doSomething();
+
+    // Concurrent first access still yields exactly one instance
+    SingletonHolder<Singleton>::destroy();
+    std::vector<Singleton*> seen(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        threads.emplace_back([&seen, i] { seen[i] = &SingletonHolder<Singleton>::getCached(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    bool same = true;
+    for (Singleton* instance : seen) {
+        same = same && instance == seen.front();
+    }
+    std::cout << "Singleton: all threads share one instance: " << std::boolalpha << same << std::endl;
+
+    // Access cost once the instance exists, 64 threads at a time, against
+    // taking a mutex on every call. The atomic loads inside get() and
+    // getCached() keep the calls from being optimized out.
+    {
+        std::mutex lockedMutex;
+        double plain = nanosecondsPerCall(64, 1000000, [](std::size_t) { SingletonHolder<Singleton>::get(); });
+        double cached = nanosecondsPerCall(64, 1000000, [](std::size_t) { SingletonHolder<Singleton>::getCached(); });
+        double locked = nanosecondsPerCall(64, 100000, [&](std::size_t) {
+            std::lock_guard<std::mutex> lock(lockedMutex);
+        });
+        std::cout << "Singleton: 64 threads, get " << plain << " ns, getCached " << cached
+                  << " ns, mutex " << locked << " ns per call" << std::endl;
+    }
+
+    SingletonHolder<Singleton>::destroy();
+
+    // Dependent services started together: Logger and Database overlap
+    ServiceRegistry registry;
+    registry.add<Config>("config", {}, [](ServiceRegistry&) {
+        return std::make_shared<Config>();
+    });
+    registry.add<Logger>("logger", {"config"}, [](ServiceRegistry& r) {
+        return std::make_shared<Logger>(r.get<Config>("config"));
+    });
+    registry.add<Database>("database", {"config"}, [](ServiceRegistry& r) {
+        return std::make_shared<Database>(r.get<Config>("config"));
+    });
+    auto start = std::chrono::steady_clock::now();
+    registry.startAll(4);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "ServiceRegistry: started in " << elapsed.count() << " ms" << std::endl;
+    registry.report(std::cout);
+
+    // Hot counters updated core-locally and merged only when read
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i) {
+        workers.emplace_back([] {
+            for (int n = 0; n < 100000; ++n) {
+                ThreadScoped<HitCounter>::local().hits.fetch_add(1, std::memory_order_relaxed);
+                NodeScoped<HitCounter>::local().hits.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto sum = [](std::uint64_t total, const HitCounter& counter) {
+        return total + counter.hits.load(std::memory_order_relaxed);
+    };
+    std::cout << "Per-thread hits: " << ThreadScoped<HitCounter>::reduce(std::uint64_t{0}, sum)
+              << ", per-node hits: " << NodeScoped<HitCounter>::reduce(std::uint64_t{0}, sum)
+              << " across " << NodeScoped<HitCounter>::nodes() << " node(s)" << std::endl;
+
+    // The same counting loop as thread count grows: per-thread and per-node
+    // counters against one atomic every thread increments
+    HitCounter shared;
+    for (std::size_t count : {1, 2, 4, 8, 16, 32}) {
+        const std::size_t calls = 4000000 / count;
+        double perThread = nanosecondsPerCall(count, calls, [](std::size_t) {
+            ThreadScoped<HitCounter>::local().hits.fetch_add(1, std::memory_order_relaxed);
+        });
+        double perNode = nanosecondsPerCall(count, calls, [](std::size_t) {
+            NodeScoped<HitCounter>::local().hits.fetch_add(1, std::memory_order_relaxed);
+        });
+        double single = nanosecondsPerCall(count, calls, [&shared](std::size_t) {
+            shared.hits.fetch_add(1, std::memory_order_relaxed);
+        });
+        std::cout << count << " thread(s): per-thread " << perThread << " ns, per-node " << perNode
+                  << " ns, shared atomic " << single << " ns per increment" << std::endl;
+    }
     return 0;
 }